@@ -0,0 +1,407 @@
+#include "header_files/online_state.h"
+
+// Microbenchmarks for the scheduler internals. Nothing here starts a child
+// process: every benchmark fills the data structures directly and times
+// only the operation under test, at 10^2 to 10^6 entries.
+//
+// Usage: ./benchmark_schedulers [name]   (runs every benchmark by default)
+// The history benchmarks use the predictor chosen by SCHEDULER_PREDICTOR.
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+// Heap allocations made by the process, counted by the wrappers below
+uint64_t bench_allocations = 0;
+
+void* malloc(size_t size) {
+    bench_allocations++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    bench_allocations++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    bench_allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+// Clock and allocation count at bench_start, totals at bench_stop
+uint64_t bench_start_ns = 0;
+uint64_t bench_start_allocations = 0;
+uint64_t bench_elapsed_ns = 0;
+uint64_t bench_allocated = 0;
+
+// Keeps results alive so the compiler cannot drop the measured calls
+volatile uint64_t bench_sink = 0;
+
+void bench_start() {
+    bench_start_allocations = bench_allocations;
+    bench_start_ns = clock_ns();
+}
+
+void bench_stop() {
+    bench_elapsed_ns = clock_ns() - bench_start_ns;
+    bench_allocated = bench_allocations - bench_start_allocations;
+}
+
+// Registers n jobs spread over commands distinct commands. Every command
+// gets a completed run, so estimates differ and the ready sets are ordered.
+void bench_fill_jobs(int n, int commands, Process** jobs) {
+    char command[64];
+    for (int i = 0; i < n; i++) {
+        snprintf(command, sizeof(command), "job %d", i % commands);
+        jobs[i] = add_process(command, i);
+        if (i < commands) {
+            update_process_history(jobs[i]->command_id, (uint64_t)(i * 7919) % 5000 * NS_PER_MS);
+        }
+    }
+}
+
+// enqueue then dequeue every job on one run queue, 2n operations
+uint64_t bench_enqueue_dequeue(int n) {
+    Process* jobs = (Process*)calloc(n, sizeof(Process));
+    Queue* queue = createQueue();
+
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        enqueue(queue, &jobs[i]);
+    }
+    for (int i = 0; i < n; i++) {
+        bench_sink += dequeue(queue)->process_id;
+    }
+    bench_stop();
+
+    free(queue);
+    free(jobs);
+    return 2 * (uint64_t)n;
+}
+
+// Demotes the head job of the top level, then boosts, with n jobs queued
+// over MLFQ_MAX_LEVELS levels
+uint64_t bench_boost_priorities(int n) {
+    Process* jobs = (Process*)calloc(n, sizeof(Process));
+    LevelQueues levels;
+    init_level_queues(&levels, MLFQ_MAX_LEVELS);
+    for (int i = 0; i < n; i++) {
+        push_level(&levels, i % MLFQ_MAX_LEVELS, &jobs[i]);
+    }
+
+    uint64_t last_boost_time = 0;
+    int level;
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        push_level(&levels, 1 + i % (MLFQ_MAX_LEVELS - 1), pop_highest(&levels, &level));
+        boost_priorities(&levels, &last_boost_time, i);
+    }
+    bench_stop();
+    bench_sink += last_boost_time;
+
+    free(jobs);
+    return n;
+}
+
+// Takes the highest priority job and demotes it, n times with n jobs queued
+// over MLFQ_MAX_LEVELS levels
+uint64_t bench_pop_highest(int n) {
+    Process* jobs = (Process*)calloc(n, sizeof(Process));
+    LevelQueues levels;
+    init_level_queues(&levels, MLFQ_MAX_LEVELS);
+    for (int i = 0; i < n; i++) {
+        push_level(&levels, i % MLFQ_MAX_LEVELS, &jobs[i]);
+    }
+
+    int level;
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        Process* process = pop_highest(&levels, &level);
+        push_level(&levels, (level < MLFQ_MAX_LEVELS - 1) ? level + 1 : level, process);
+        bench_sink += level;
+    }
+    bench_stop();
+
+    free(jobs);
+    return n;
+}
+
+// Runs n CFS slices with n jobs of mixed weights ready
+uint64_t bench_cfs_pick(int n) {
+    Process* jobs = (Process*)calloc(n, sizeof(Process));
+    CfsQueue cfs;
+    init_cfs_queue(&cfs);
+    for (int i = 0; i < n; i++) {
+        jobs[i].process_id = i;
+        jobs[i].weight = cfs_nice_weights[i % 40];
+        cfs_enqueue(&cfs, i, &jobs[i]);
+    }
+
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        Process* process = cfs_pick(&cfs);
+        cfs_account(&cfs, process, (uint64_t)cfs_slice(&cfs, process) * NS_PER_MS);
+        cfs_enqueue(&cfs, process - jobs, process);
+    }
+    bench_stop();
+
+    free_cfs_queue(&cfs);
+    free(jobs);
+    return n;
+}
+
+// Runs n stride (lottery when lottery is set) slices with n jobs of mixed
+// tickets ready
+uint64_t bench_share_pick(int n, bool lottery) {
+    Process* jobs = (Process*)calloc(n, sizeof(Process));
+    ShareQueue share;
+    init_share_queue(&share, lottery);
+    for (int i = 0; i < n; i++) {
+        jobs[i].process_id = i;
+        jobs[i].tickets = 50 + i % 200;
+        share_arrive(&share, i, &jobs[i]);
+        share_enqueue(&share, i, &jobs[i]);
+    }
+
+    int id;
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        Process* process = share_pick(&share, &id);
+        share_account(&share, process, 10 * NS_PER_MS);
+        share_enqueue(&share, id, process);
+    }
+    bench_stop();
+
+    free_share_queue(&share);
+    free(jobs);
+    return n;
+}
+
+uint64_t bench_stride_pick(int n) {
+    return bench_share_pick(n, false);
+}
+
+uint64_t bench_lottery_pick(int n) {
+    return bench_share_pick(n, true);
+}
+
+// Runs n EDF preemptions with n jobs, half of them with deadlines, ready
+uint64_t bench_edf_pick(int n) {
+    Process* jobs = (Process*)calloc(n, sizeof(Process));
+    DeadlineQueue edf;
+    init_deadline_queue(&edf);
+    for (int i = 0; i < n; i++) {
+        jobs[i].process_id = i;
+        jobs[i].deadline = (i % 2) ? (uint64_t)(i * 7919 % n + 1) * NS_PER_MS : 0;
+        deadline_enqueue(&edf, i, &jobs[i], 10 * NS_PER_MS);
+    }
+
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        Process* process = deadline_pick(&edf);
+        process->deadline += 10 * NS_PER_MS * (process->deadline != 0);
+        deadline_enqueue(&edf, process - jobs, process, 10 * NS_PER_MS);
+    }
+    bench_stop();
+
+    free_deadline_queue(&edf);
+    free(jobs);
+    return n;
+}
+
+// Drains n ready jobs over n/10 commands in shortest-job order
+uint64_t bench_get_shortest_job(int n) {
+    Process** jobs = (Process**)malloc(sizeof(Process*) * n);
+    bench_fill_jobs(n, n / 10 > 0 ? n / 10 : 1, jobs);
+    for (int i = 0; i < n; i++) {
+        add_ready_job(jobs[i]);
+    }
+
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        bench_sink += get_shortest_job()->process_id;
+    }
+    bench_stop();
+
+    free(jobs);
+    free_online_state();
+    return n;
+}
+
+// Re-keys the preempted SRTF jobs of 100 of n/10 commands, with n jobs
+// preempted, as after 100 completions
+uint64_t bench_refresh_srtf_command(int n) {
+    Process** jobs = (Process**)malloc(sizeof(Process*) * n);
+    int commands = n / 10 > 0 ? n / 10 : 1;
+    bench_fill_jobs(n, commands, jobs);
+    for (int i = 0; i < n; i++) {
+        jobs[i]->started = true;
+        jobs[i]->burst_time = (uint64_t)(i % 100) * NS_PER_MS;
+        add_srtf_job(jobs[i]);
+    }
+
+    bench_start();
+    for (int i = 0; i < 100; i++) {
+        refresh_srtf_command(i * 7919 % commands);
+    }
+    bench_stop();
+
+    bench_sink += ready_heap_top(&srtf_ready);
+    free(jobs);
+    free_online_state();
+    return 100;
+}
+
+// Re-keys the preempted SRTF jobs of 100 commands with one ready job each,
+// among n jobs of which the rest already ran, as in a long run whose table
+// grew far beyond its ready set
+uint64_t bench_refresh_srtf_sparse(int n) {
+    Process** jobs = (Process**)malloc(sizeof(Process*) * n);
+    int commands = n / 10 > 0 ? n / 10 : 1;
+    bench_fill_jobs(n, commands, jobs);
+    for (int i = 0; i < n; i++) {
+        jobs[i]->started = true;
+        jobs[i]->burst_time = (uint64_t)(i % 100) * NS_PER_MS;
+    }
+    for (int i = 0; i < 100 && i < n; i++) {
+        add_srtf_job(jobs[i * (n / 100 > 0 ? n / 100 : 1)]);
+    }
+
+    bench_start();
+    for (int i = 0; i < 100; i++) {
+        refresh_srtf_command(jobs[i * (n / 100 > 0 ? n / 100 : 1) % n]->command_id);
+    }
+    bench_stop();
+
+    bench_sink += ready_heap_top(&srtf_ready);
+    free(jobs);
+    free_online_state();
+    return 100;
+}
+
+// Looks up each of n distinct commands once
+uint64_t bench_find_process_history(int n) {
+    Process** jobs = (Process**)malloc(sizeof(Process*) * n);
+    bench_fill_jobs(n, n, jobs);
+
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        bench_sink += find_process_history(jobs[i]->command);
+    }
+    bench_stop();
+
+    free(jobs);
+    free_online_state();
+    return n;
+}
+
+// Records a completed burst for each of n commands, half of them with ready jobs
+uint64_t bench_update_process_history(int n) {
+    Process** jobs = (Process**)malloc(sizeof(Process*) * n);
+    bench_fill_jobs(n, n, jobs);
+    for (int i = 0; i < n; i += 2) {
+        add_ready_job(jobs[i]);
+    }
+
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        update_process_history(jobs[i]->command_id, (uint64_t)(i * 104729) % 5000 * NS_PER_MS);
+    }
+    bench_stop();
+
+    free(jobs);
+    free_online_state();
+    return n;
+}
+
+// Computes the MLFQ level of n jobs over n/10 commands
+uint64_t bench_get_priority(int n) {
+    Process** jobs = (Process**)malloc(sizeof(Process*) * n);
+    bench_fill_jobs(n, n / 10 > 0 ? n / 10 : 1, jobs);
+
+    int quanta[] = {1000, 2000, 3000};
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        bench_sink += get_priority(*jobs[i], quanta, 3);
+    }
+    bench_stop();
+
+    free(jobs);
+    free_online_state();
+    return n;
+}
+
+// Formats n result rows into a sink on /dev/null
+uint64_t bench_write_to_csv(int n) {
+    Process** jobs = (Process**)malloc(sizeof(Process*) * n);
+    bench_fill_jobs(n, n / 10 > 0 ? n / 10 : 1, jobs);
+    ResultSink csv;
+    if (open_result_sink(&csv, "/dev/null", RESULT_CSV_HEADER) < 0) {
+        exit(1);
+    }
+
+    bench_start();
+    for (int i = 0; i < n; i++) {
+        jobs[i]->finished = true;
+        jobs[i]->burst_time = i;
+        jobs[i]->turnaround_time = 2 * i;
+        jobs[i]->waiting_time = i;
+        write_to_csv(&csv, *jobs[i]);
+    }
+    bench_stop();
+
+    close_result_sink(&csv);
+    free(jobs);
+    free_online_state();
+    return n;
+}
+
+typedef struct {
+    const char* name;
+    uint64_t (*run)(int n);  // Returns the number of operations timed
+} Benchmark;
+
+Benchmark benchmarks[] = {
+    {"enqueue_dequeue", bench_enqueue_dequeue},
+    {"boost_priorities", bench_boost_priorities},
+    {"pop_highest", bench_pop_highest},
+    {"cfs_pick", bench_cfs_pick},
+    {"stride_pick", bench_stride_pick},
+    {"lottery_pick", bench_lottery_pick},
+    {"edf_pick", bench_edf_pick},
+    {"get_shortest_job", bench_get_shortest_job},
+    {"refresh_srtf_command", bench_refresh_srtf_command},
+    {"refresh_srtf_sparse", bench_refresh_srtf_sparse},
+    {"find_process_history", bench_find_process_history},
+    {"update_process_history", bench_update_process_history},
+    {"get_priority", bench_get_priority},
+    {"write_to_csv", bench_write_to_csv},
+};
+
+int main(int argc, char* argv[]) {
+    const char* only = (argc > 1) ? argv[1] : NULL;
+    if (burst_predictor_from_env() < 0) {
+        return 1;
+    }
+    int count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+    printf("%-24s %10s %12s %12s\n", "Benchmark", "Entries", "ns/op", "allocs/op");
+    for (int b = 0; b < count; b++) {
+        if (only != NULL && strcmp(only, benchmarks[b].name) != 0) {
+            continue;
+        }
+        for (int n = 100; n <= 1000000; n *= 10) {
+            uint64_t ops = benchmarks[b].run(n);
+            printf("%-24s %10d %12.1f %12.4f\n", benchmarks[b].name, n,
+                   (double)bench_elapsed_ns / ops, (double)bench_allocated / ops);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
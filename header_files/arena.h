@@ -0,0 +1,58 @@
+#pragma once
+
+// Bump allocator. Memory is carved out of large blocks and only returned
+// all at once by free_arena, which makes many small allocations cheap.
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *blocks;  // Most recent block first
+} Arena;
+
+// Returns size bytes aligned for any type, never NULL unless out of memory
+void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    ArenaBlock* block = arena->blocks;
+    if (block == NULL || block->size - block->used < size) {
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + block_size);
+        if (block == NULL) {
+            return NULL;
+        }
+        block->next = arena->blocks;
+        block->used = 0;
+        block->size = block_size;
+        arena->blocks = block;
+    }
+    void* ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+// Copies a string into the arena
+char* arena_strdup(Arena* arena, const char* str) {
+    size_t len = strlen(str) + 1;
+    char* copy = (char*)arena_alloc(arena, len);
+    if (copy != NULL) {
+        memcpy(copy, str, len);
+    }
+    return copy;
+}
+
+void free_arena(Arena* arena) {
+    while (arena->blocks != NULL) {
+        ArenaBlock* next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+// Burst-time predictors for the online schedulers. Each command keeps a
+// prediction plus, depending on the predictor, some extra state:
+//
+//   mean       Running mean of every burst (the original behaviour)
+//   ewma       Exponentially weighted moving average, new = a*x + (1-a)*old
+//   median     Median of the last PREDICT_WINDOW bursts
+//   p<NN>      NN-th percentile from a decaying log-scale histogram, so a
+//              command with a long tail is not scheduled as a short one
+//
+// Select one with SCHEDULER_PREDICTOR=mean|ewma[:alpha]|median|p<NN>.
+// The extra state is a fixed-size block per command, see
+// predictor_state_size(), so it can live in a plain array next to the
+// history. The error of every warm prediction is accumulated in
+// prediction_error.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "clock.h"
+
+typedef enum {
+    PREDICT_MEAN,
+    PREDICT_EWMA,
+    PREDICT_MEDIAN,
+    PREDICT_QUANTILE
+} PredictorKind;
+
+typedef struct {
+    PredictorKind kind;
+    double alpha;     // EWMA weight of the newest burst
+    double quantile;  // Percentile predicted by PREDICT_QUANTILE, in (0, 1]
+} BurstPredictor;
+
+BurstPredictor burst_predictor = {PREDICT_MEAN, 0.5, 0.9};
+
+#define PREDICT_WINDOW 15
+
+typedef struct {
+    uint64_t samples[PREDICT_WINDOW];
+    uint32_t next;
+    uint32_t count;
+} MedianWindow;
+
+// Histogram over bursts in microseconds: values below 4 get a bucket each,
+// every power of two above is split into 4 buckets (at most 25% wide)
+#define SKETCH_SUB_BITS 2
+#define SKETCH_MAX_EXPONENT 40
+#define SKETCH_BUCKETS ((1 << SKETCH_SUB_BITS) + (SKETCH_MAX_EXPONENT - SKETCH_SUB_BITS + 1) * (1 << SKETCH_SUB_BITS))
+#define SKETCH_DECAY_TOTAL 512  // Counts are halved when they add up to this
+
+typedef struct {
+    uint16_t counts[SKETCH_BUCKETS];
+    uint32_t total;
+} QuantileSketch;
+
+// Accumulated error of warm predictions, those made from at least one burst
+typedef struct {
+    uint64_t samples;
+    uint64_t under_predicted;  // The job ran longer than predicted
+    double abs_error_ns;
+    double relative_error;     // Sum of |predicted - actual| / actual
+} PredictionError;
+
+PredictionError prediction_error = {0};
+
+// Parses a SCHEDULER_PREDICTOR value. Returns -1 if it is not recognized.
+int configure_burst_predictor(const char* spec) {
+    if (strcmp(spec, "mean") == 0) {
+        burst_predictor.kind = PREDICT_MEAN;
+    } else if (strncmp(spec, "ewma", 4) == 0 && (spec[4] == '\0' || spec[4] == ':')) {
+        burst_predictor.kind = PREDICT_EWMA;
+        if (spec[4] == ':') {
+            double alpha = atof(spec + 5);
+            if (alpha <= 0 || alpha > 1) return -1;
+            burst_predictor.alpha = alpha;
+        }
+    } else if (strcmp(spec, "median") == 0) {
+        burst_predictor.kind = PREDICT_MEDIAN;
+    } else if (spec[0] == 'p') {
+        double percentile = atof(spec + 1);
+        if (percentile <= 0 || percentile > 100) return -1;
+        burst_predictor.kind = PREDICT_QUANTILE;
+        burst_predictor.quantile = percentile / 100;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Applies SCHEDULER_PREDICTOR, keeping the running mean when it is unset
+int burst_predictor_from_env() {
+    const char* spec = getenv("SCHEDULER_PREDICTOR");
+    if (spec == NULL || spec[0] == '\0') {
+        return 0;
+    }
+    if (configure_burst_predictor(spec) < 0) {
+        fprintf(stderr, "Unknown SCHEDULER_PREDICTOR %s, expected mean, ewma[:alpha], median or p<NN>\n", spec);
+        return -1;
+    }
+    return 0;
+}
+
+// Bytes of extra state each command needs under the current predictor
+size_t predictor_state_size() {
+    switch (burst_predictor.kind) {
+        case PREDICT_MEDIAN: return sizeof(MedianWindow);
+        case PREDICT_QUANTILE: return sizeof(QuantileSketch);
+        default: return 0;
+    }
+}
+
+int sketch_bucket(uint64_t us) {
+    if (us < (1 << SKETCH_SUB_BITS)) {
+        return (int)us;
+    }
+    int exponent = 63 - __builtin_clzll(us);
+    if (exponent > SKETCH_MAX_EXPONENT) {
+        return SKETCH_BUCKETS - 1;
+    }
+    int sub = (us >> (exponent - SKETCH_SUB_BITS)) & ((1 << SKETCH_SUB_BITS) - 1);
+    return (1 << SKETCH_SUB_BITS) + (exponent - SKETCH_SUB_BITS) * (1 << SKETCH_SUB_BITS) + sub;
+}
+
+// Midpoint of a bucket, in microseconds
+uint64_t sketch_bucket_value(int bucket) {
+    if (bucket < (1 << SKETCH_SUB_BITS)) {
+        return bucket;
+    }
+    int exponent = (bucket >> SKETCH_SUB_BITS) - 1 + SKETCH_SUB_BITS;
+    uint64_t sub = bucket & ((1 << SKETCH_SUB_BITS) - 1);
+    uint64_t width = UINT64_C(1) << (exponent - SKETCH_SUB_BITS);
+    return (((1 << SKETCH_SUB_BITS) + sub) << (exponent - SKETCH_SUB_BITS)) + width / 2;
+}
+
+void sketch_add(QuantileSketch* sketch, uint64_t ns) {
+    if (sketch->total + 1 >= SKETCH_DECAY_TOTAL) {
+        // Forget half of the past, so the sketch follows workload changes
+        sketch->total = 0;
+        for (int i = 0; i < SKETCH_BUCKETS; i++) {
+            sketch->counts[i] /= 2;
+            sketch->total += sketch->counts[i];
+        }
+    }
+    sketch->counts[sketch_bucket(ns / NS_PER_US)]++;
+    sketch->total++;
+}
+
+uint64_t sketch_quantile(QuantileSketch* sketch, double quantile) {
+    uint64_t target = (uint64_t)(quantile * sketch->total + 0.999999);
+    uint64_t seen = 0;
+    for (int i = 0; i < SKETCH_BUCKETS; i++) {
+        seen += sketch->counts[i];
+        if (seen >= target && sketch->counts[i] > 0) {
+            return sketch_bucket_value(i) * NS_PER_US;
+        }
+    }
+    return 0;
+}
+
+uint64_t window_median(MedianWindow* window) {
+    uint64_t sorted[PREDICT_WINDOW];
+    int n = window->count;
+    for (int i = 0; i < n; i++) {
+        // Insertion sort, the window is tiny
+        uint64_t value = window->samples[i];
+        int j = i;
+        for (; j > 0 && sorted[j - 1] > value; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = value;
+    }
+    return (n % 2) ? sorted[n / 2] : sorted[n / 2 - 1] / 2 + sorted[n / 2] / 2;
+}
+
+// Adds the prediction's error to prediction_error
+void record_prediction_error(uint64_t predicted, uint64_t actual) {
+    uint64_t error = (predicted > actual) ? predicted - actual : actual - predicted;
+    prediction_error.samples++;
+    prediction_error.under_predicted += actual > predicted;
+    prediction_error.abs_error_ns += error;
+    prediction_error.relative_error += actual ? (double)error / actual : (error ? 1.0 : 0.0);
+}
+
+// Folds a completed burst into a command's predictor. count is the number
+// of bursts seen before this one, prediction the current prediction, state
+// the command's predictor_state_size() block. Returns the new prediction.
+uint64_t predictor_update(void* state, uint64_t prediction, int count, uint64_t actual) {
+    if (count > 0) {
+        record_prediction_error(prediction, actual);
+    }
+    switch (burst_predictor.kind) {
+        case PREDICT_MEAN:
+            // Incremental form, the sum of all bursts is never formed
+            if (count == 0) return actual;
+            return (actual >= prediction) ? prediction + (actual - prediction) / (count + 1)
+                                          : prediction - (prediction - actual) / (count + 1);
+        case PREDICT_EWMA:
+            if (count == 0) return actual;
+            return (uint64_t)(burst_predictor.alpha * actual + (1 - burst_predictor.alpha) * prediction);
+        case PREDICT_MEDIAN: {
+            MedianWindow* window = (MedianWindow*)state;
+            window->samples[window->next] = actual;
+            window->next = (window->next + 1) % PREDICT_WINDOW;
+            if (window->count < PREDICT_WINDOW) window->count++;
+            return window_median(window);
+        }
+        case PREDICT_QUANTILE: {
+            QuantileSketch* sketch = (QuantileSketch*)state;
+            sketch_add(sketch, actual);
+            return sketch_quantile(sketch, burst_predictor.quantile);
+        }
+    }
+    return actual;
+}
+
+// One-line summary of prediction_error
+void print_prediction_error(FILE* out) {
+    if (prediction_error.samples == 0) {
+        return;
+    }
+    fprintf(out, "Prediction error: %lu predictions, mean absolute error %.3f ms, mean relative error %.1f%%, %.1f%% under-predicted\n",
+            prediction_error.samples, prediction_error.abs_error_ns / prediction_error.samples / NS_PER_MS,
+            100.0 * prediction_error.relative_error / prediction_error.samples,
+            100.0 * prediction_error.under_predicted / prediction_error.samples);
+}
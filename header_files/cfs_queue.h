@@ -0,0 +1,129 @@
+#pragma once
+
+// Ready set of the completely fair scheduler (CFS), after the Linux one.
+// Every job accumulates virtual runtime, the time it held the CPU scaled
+// by CFS_NICE_0_WEIGHT / weight, so heavier jobs age more slowly and get a
+// larger share. The job with the least vruntime runs next, for its weight's
+// share of the target latency, but at least the minimum granularity; the
+// period stretches once the runnable jobs would get less than that.
+// Jobs enter the queue no lower than its min_vruntime, so a newcomer cannot
+// hold the CPU for as long as it takes to catch up with the others.
+//
+// The target latency and minimum granularity default to 48 and 6 ms, set
+// them in ms with SCHEDULER_CFS=<latency>:<granularity>.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "process.h"
+#include "ready_heap.h"
+
+#define CFS_NICE_0_WEIGHT 1024
+#define CFS_TARGET_LATENCY 48    // ms
+#define CFS_MIN_GRANULARITY 6    // ms
+
+// Weights of nice -20..19, each level gets about 10% less CPU than the one
+// before it (the kernel's sched_prio_to_weight)
+static const int cfs_nice_weights[40] = {
+    88761, 71755, 56483, 46273, 36291,
+    29154, 23254, 18705, 14949, 11916,
+     9548,  7620,  6100,  4904,  3906,
+     3121,  2501,  1991,  1586,  1277,
+     1024,   820,   655,   526,   423,
+      335,   272,   215,   172,   137,
+      110,    87,    70,    56,    45,
+       36,    29,    23,    18,    15,
+};
+
+typedef struct {
+    ReadyHeap ready;        // Ids keyed by vruntime, ties in arrival order
+    Process **jobs;         // Id -> job, for the ids in ready
+    int jobs_capacity;
+    uint64_t ready_weight;  // Sum of the weights in ready
+    uint64_t min_vruntime;  // Never decreases
+    int latency;            // ms
+    int granularity;        // ms
+} CfsQueue;
+
+// Load weight of a job, nice 0 unless set
+int cfs_weight(Process* process) {
+    return process->weight > 0 ? process->weight : CFS_NICE_0_WEIGHT;
+}
+
+// Reads SCHEDULER_CFS
+void init_cfs_queue(CfsQueue* cfs) {
+    memset(cfs, 0, sizeof(CfsQueue));
+    cfs->latency = CFS_TARGET_LATENCY;
+    cfs->granularity = CFS_MIN_GRANULARITY;
+    const char* spec = getenv("SCHEDULER_CFS");
+    if (spec != NULL && spec[0] != '\0') {
+        int latency, granularity;
+        if (sscanf(spec, "%d:%d", &latency, &granularity) == 2 && granularity > 0 && latency >= granularity) {
+            cfs->latency = latency;
+            cfs->granularity = granularity;
+        } else {
+            fprintf(stderr, "Ignoring SCHEDULER_CFS=%s, expected <latency>:<granularity> in ms\n", spec);
+        }
+    }
+}
+
+void free_cfs_queue(CfsQueue* cfs) {
+    free_ready_heap(&cfs->ready);
+    free(cfs->jobs);
+    memset(cfs, 0, sizeof(CfsQueue));
+}
+
+// Makes a job ready under id, which must be unique among the ready jobs
+void cfs_enqueue(CfsQueue* cfs, int id, Process* process) {
+    if (id >= cfs->jobs_capacity) {
+        int new_capacity = cfs->jobs_capacity ? cfs->jobs_capacity : 64;
+        while (new_capacity <= id) {
+            new_capacity *= 2;
+        }
+        cfs->jobs = (Process**)realloc(cfs->jobs, sizeof(Process*) * new_capacity);
+        cfs->jobs_capacity = new_capacity;
+    }
+    if (process->vruntime < cfs->min_vruntime) {
+        process->vruntime = cfs->min_vruntime;
+    }
+    cfs->jobs[id] = process;
+    cfs->ready_weight += cfs_weight(process);
+    ready_heap_update(&cfs->ready, id, process->vruntime, process->process_id);
+}
+
+// Removes and returns the ready job with the least vruntime, or NULL
+Process* cfs_pick(CfsQueue* cfs) {
+    int id = ready_heap_top(&cfs->ready);
+    if (id == -1) {
+        return NULL;
+    }
+    ready_heap_remove(&cfs->ready, id);
+    Process* process = cfs->jobs[id];
+    cfs->ready_weight -= cfs_weight(process);
+    return process;
+}
+
+// Slice in ms for a job just taken by cfs_pick
+int cfs_slice(CfsQueue* cfs, Process* running) {
+    uint64_t runnable = cfs->ready.size + 1;
+    uint64_t period = cfs->latency;
+    if (runnable * cfs->granularity > period) {
+        period = runnable * cfs->granularity;
+    }
+    uint64_t weight = cfs_weight(running);
+    uint64_t slice = period * weight / (cfs->ready_weight + weight);
+    return slice > (uint64_t)cfs->granularity ? (int)slice : cfs->granularity;
+}
+
+// Charges a slice of elapsed_ns to the job that ran it
+void cfs_account(CfsQueue* cfs, Process* running, uint64_t elapsed_ns) {
+    running->vruntime += elapsed_ns * CFS_NICE_0_WEIGHT / cfs_weight(running);
+    uint64_t least = running->vruntime;
+    int id = ready_heap_top(&cfs->ready);
+    if (id != -1 && cfs->ready.keys[id] < least) {
+        least = cfs->ready.keys[id];
+    }
+    if (least > cfs->min_vruntime) {
+        cfs->min_vruntime = least;
+    }
+}
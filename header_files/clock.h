@@ -0,0 +1,39 @@
+#pragma once
+
+// Time base shared by every scheduler. All timestamps and durations are
+// taken from CLOCK_MONOTONIC in nanoseconds, so a wall-clock step can never
+// make a duration wrap. Quanta and boost intervals are still given in ms.
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+#define NS_PER_US UINT64_C(1000)
+#define NS_PER_MS UINT64_C(1000000)
+#define NS_PER_SEC UINT64_C(1000000000)
+
+// Monotonic clock in nanoseconds
+uint64_t clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+// User plus system time recorded in a rusage, in nanoseconds
+uint64_t rusage_cpu_ns(const struct rusage* usage) {
+    uint64_t us = (uint64_t)(usage->ru_utime.tv_sec + usage->ru_stime.tv_sec) * 1000000
+                + (uint64_t)(usage->ru_utime.tv_usec + usage->ru_stime.tv_usec);
+    return us * NS_PER_US;
+}
+
+// CPU time a live (running or stopped) child has used so far, in
+// nanoseconds, or 0 if its CPU clock cannot be read. Only covers the child
+// itself; wait4 reports the full figure, including descendants, at exit.
+uint64_t child_cpu_time_ns(pid_t pid) {
+    clockid_t clock;
+    struct timespec ts;
+    if (pid <= 0 || clock_getcpuclockid(pid, &clock) != 0 || clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+// Interned command strings. Every distinct command is stored once and given
+// a stable integer id, so per-command data (like the burst history) can be
+// kept in plain arrays indexed by id instead of being searched by strcmp.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "arena.h"
+
+#define COMMAND_TABLE_INITIAL_SLOTS 64
+
+typedef struct {
+    char **commands;   // id -> interned string
+    uint64_t *hashes;  // id -> hash of the string, kept for rehashing
+    int count;
+    int capacity;
+
+    int *slots;        // Open addressing index, -1 marks an empty slot
+    int slot_count;    // Always a power of two
+
+    Arena strings;     // Storage for the interned strings
+} CommandTable;
+
+CommandTable command_table = {0};
+
+// FNV-1a hash of a command string
+uint64_t hash_command(const char* command) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (const unsigned char* c = (const unsigned char*)command; *c; c++) {
+        hash ^= *c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Rebuilds the slot index with new_slot_count slots
+void rehash_command_table(CommandTable* table, int new_slot_count) {
+    free(table->slots);
+    table->slots = (int*)malloc(sizeof(int) * new_slot_count);
+    memset(table->slots, -1, sizeof(int) * new_slot_count);
+    table->slot_count = new_slot_count;
+
+    for (int id = 0; id < table->count; id++) {
+        uint64_t mask = new_slot_count - 1;
+        uint64_t slot = table->hashes[id] & mask;
+        while (table->slots[slot] != -1) {
+            slot = (slot + 1) & mask;
+        }
+        table->slots[slot] = id;
+    }
+}
+
+// Returns the id of command, or -1 if it was never interned
+int lookup_command(CommandTable* table, const char* command) {
+    if (table->slot_count == 0) {
+        return -1;
+    }
+    uint64_t hash = hash_command(command);
+    uint64_t mask = table->slot_count - 1;
+    for (uint64_t slot = hash & mask; table->slots[slot] != -1; slot = (slot + 1) & mask) {
+        int id = table->slots[slot];
+        if (table->hashes[id] == hash && strcmp(table->commands[id], command) == 0) {
+            return id;
+        }
+    }
+    return -1;
+}
+
+// Returns the id of command, adding it to the table if needed
+int intern_command(CommandTable* table, const char* command) {
+    int id = lookup_command(table, command);
+    if (id != -1) {
+        return id;
+    }
+
+    // Keep the load factor at or below one half
+    if (2 * (table->count + 1) > table->slot_count) {
+        int new_slot_count = table->slot_count ? table->slot_count * 2 : COMMAND_TABLE_INITIAL_SLOTS;
+        rehash_command_table(table, new_slot_count);
+    }
+    if (table->count == table->capacity) {
+        table->capacity = table->capacity ? table->capacity * 2 : COMMAND_TABLE_INITIAL_SLOTS;
+        table->commands = (char**)realloc(table->commands, sizeof(char*) * table->capacity);
+        table->hashes = (uint64_t*)realloc(table->hashes, sizeof(uint64_t) * table->capacity);
+    }
+
+    id = table->count++;
+    table->commands[id] = arena_strdup(&table->strings, command);
+    table->hashes[id] = hash_command(command);
+
+    uint64_t mask = table->slot_count - 1;
+    uint64_t slot = table->hashes[id] & mask;
+    while (table->slots[slot] != -1) {
+        slot = (slot + 1) & mask;
+    }
+    table->slots[slot] = id;
+    return id;
+}
+
+// Releases every interned string and the index
+void free_command_table(CommandTable* table) {
+    free_arena(&table->strings);
+    free(table->commands);
+    free(table->hashes);
+    free(table->slots);
+    memset(table, 0, sizeof(CommandTable));
+}
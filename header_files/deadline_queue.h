@@ -0,0 +1,172 @@
+#pragma once
+
+// Ready set of the Earliest Deadline First (EDF) scheduler. Jobs may carry a
+// deadline, absolute on the scheduler clock; the ready job with the earliest
+// one runs next, and jobs without a deadline run after them in arrival
+// order. Every job is ready with the time it is still predicted to need,
+// from its command's burst history.
+//
+// A job with a deadline is admitted only if, run in deadline order from
+// now, it and every other job with a deadline are predicted to finish in
+// time. Infeasible jobs are admitted anyway and counted as at risk, unless
+// SCHEDULER_EDF_ADMIT=strict, which rejects them.
+//
+// Picks are O(log n). The admission check sorts the ready jobs that have a
+// deadline, O(k log k) for k of them, and only runs for jobs with one.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "process.h"
+#include "clock.h"
+#include "ready_heap.h"
+
+#define NO_DEADLINE UINT64_MAX
+
+typedef struct {
+    uint64_t jobs;          // Completed jobs that had a deadline
+    uint64_t missed;
+    uint64_t rejected;      // Refused at admission
+    uint64_t at_risk;       // Admitted although predicted to miss
+    int64_t lateness_sum;   // ns, negative when early
+    int64_t max_lateness;
+} DeadlineStats;
+
+typedef struct {
+    ReadyHeap ready;       // Ids keyed by deadline, ties in arrival order
+    Process **jobs;        // Id -> job, for the ids in ready
+    uint64_t *predicted;   // Id -> predicted remaining time when it became ready
+    int capacity;
+    bool strict;
+    DeadlineStats stats;
+} DeadlineQueue;
+
+uint64_t deadline_key(Process* process) {
+    return process->deadline ? process->deadline : NO_DEADLINE;
+}
+
+// Reads SCHEDULER_EDF_ADMIT
+void init_deadline_queue(DeadlineQueue* queue) {
+    memset(queue, 0, sizeof(DeadlineQueue));
+    const char* admit = getenv("SCHEDULER_EDF_ADMIT");
+    queue->strict = admit != NULL && strcmp(admit, "strict") == 0;
+}
+
+void free_deadline_queue(DeadlineQueue* queue) {
+    free_ready_heap(&queue->ready);
+    free(queue->jobs);
+    free(queue->predicted);
+    memset(queue, 0, sizeof(DeadlineQueue));
+}
+
+// Makes a job ready under id, predicted to need predicted_ns more
+void deadline_enqueue(DeadlineQueue* queue, int id, Process* process, uint64_t predicted_ns) {
+    if (id >= queue->capacity) {
+        int new_capacity = queue->capacity ? queue->capacity : 64;
+        while (new_capacity <= id) {
+            new_capacity *= 2;
+        }
+        queue->jobs = (Process**)realloc(queue->jobs, sizeof(Process*) * new_capacity);
+        queue->predicted = (uint64_t*)realloc(queue->predicted, sizeof(uint64_t) * new_capacity);
+        queue->capacity = new_capacity;
+    }
+    queue->jobs[id] = process;
+    queue->predicted[id] = predicted_ns;
+    ready_heap_update(&queue->ready, id, deadline_key(process), process->process_id);
+}
+
+// Ready job with the earliest deadline, or NULL
+Process* deadline_peek(DeadlineQueue* queue) {
+    int id = ready_heap_top(&queue->ready);
+    return id == -1 ? NULL : queue->jobs[id];
+}
+
+// Removes and returns the ready job with the earliest deadline, or NULL
+Process* deadline_pick(DeadlineQueue* queue) {
+    int id = ready_heap_top(&queue->ready);
+    if (id == -1) {
+        return NULL;
+    }
+    ready_heap_remove(&queue->ready, id);
+    return queue->jobs[id];
+}
+
+typedef struct {
+    uint64_t deadline;
+    uint64_t predicted;
+} DeadlineWork;
+
+static int compare_deadline_work(const void* a, const void* b) {
+    uint64_t x = ((const DeadlineWork*)a)->deadline, y = ((const DeadlineWork*)b)->deadline;
+    return (x > y) - (x < y);
+}
+
+// True if the ready jobs with a deadline, the running job (if any) and the
+// candidate are all predicted to meet their deadlines when run in deadline
+// order from now. Jobs without a deadline run last and do not count.
+bool deadline_feasible(DeadlineQueue* queue, Process* candidate, uint64_t candidate_predicted,
+                       Process* running, uint64_t running_predicted, uint64_t now) {
+    DeadlineWork* work = (DeadlineWork*)malloc(sizeof(DeadlineWork) * (queue->ready.size + 2));
+    int count = 0;
+    for (int i = 0; i < queue->ready.size; i++) {
+        int id = queue->ready.heap[i];
+        if (queue->ready.keys[id] != NO_DEADLINE) {
+            work[count++] = (DeadlineWork){queue->ready.keys[id], queue->predicted[id]};
+        }
+    }
+    if (running != NULL && running->deadline) {
+        work[count++] = (DeadlineWork){running->deadline, running_predicted};
+    }
+    work[count++] = (DeadlineWork){candidate->deadline, candidate_predicted};
+    qsort(work, count, sizeof(DeadlineWork), compare_deadline_work);
+
+    bool feasible = true;
+    uint64_t finish = now;
+    for (int i = 0; i < count && feasible; i++) {
+        finish += work[i].predicted;
+        feasible = finish <= work[i].deadline;
+    }
+    free(work);
+    return feasible;
+}
+
+// Admission check of an arriving job, see above. Returns false if the job
+// was rejected, otherwise it is made ready under id.
+bool deadline_admit(DeadlineQueue* queue, int id, Process* process, uint64_t predicted_ns,
+                    Process* running, uint64_t running_predicted, uint64_t now) {
+    if (process->deadline && !deadline_feasible(queue, process, predicted_ns, running, running_predicted, now)) {
+        if (queue->strict) {
+            queue->stats.rejected++;
+            return false;
+        }
+        queue->stats.at_risk++;
+    }
+    deadline_enqueue(queue, id, process, predicted_ns);
+    return true;
+}
+
+// Accounts for a completed job
+void deadline_complete(DeadlineQueue* queue, Process* process) {
+    if (!process->deadline) {
+        return;
+    }
+    int64_t lateness = (int64_t)(process->completion_time - process->deadline);
+    if (queue->stats.jobs == 0 || lateness > queue->stats.max_lateness) {
+        queue->stats.max_lateness = lateness;
+    }
+    queue->stats.jobs++;
+    queue->stats.missed += lateness > 0;
+    queue->stats.lateness_sum += lateness;
+}
+
+// Prints the deadline-miss ratio and lateness
+void print_deadline_stats(DeadlineStats* stats, FILE* out) {
+    if (stats->jobs == 0 && stats->rejected == 0) {
+        return;
+    }
+    double mean = stats->jobs ? (double)stats->lateness_sum / stats->jobs / NS_PER_MS : 0;
+    fprintf(out, "EDF: %lu jobs with deadlines, %lu missed (%.1f%%), mean lateness %.3f ms, max %.3f ms; %lu admitted at risk, %lu rejected\n",
+            stats->jobs, stats->missed, stats->jobs ? 100.0 * stats->missed / stats->jobs : 0.0,
+            mean, (double)stats->max_lateness / NS_PER_MS, stats->at_risk, stats->rejected);
+}
@@ -0,0 +1,297 @@
+#pragma once
+
+// Burst history kept across runs in a memory-mapped file. The file is a
+// header followed by a power-of-two array of fixed-size records, which is
+// itself an open-addressing hash table keyed by the command's FNV-1a hash.
+// Opening it is a single mmap; records are read when a command is first
+// seen and written in place whenever one of its jobs completes.
+//
+// Each record carries a sequence number that is odd while the record is
+// being written. A scheduler killed halfway through an update leaves an odd
+// sequence behind, and that record is then treated as having no history.
+// Growing the table builds a new file beside the old one and renames it
+// over, so a crash leaves either the old or the new table.
+//
+// One scheduler at a time owns the file, through an exclusive flock. A new
+// table is locked before it is written and published, so there is no
+// moment at which another scheduler can open it unlocked.
+//
+// Commands longer than HISTORY_COMMAND_MAX are not persisted.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include "command_table.h"
+
+#define HISTORY_MAGIC "SCHHIST"
+#define HISTORY_VERSION 1
+#define HISTORY_COMMAND_MAX 256
+#define HISTORY_INITIAL_SLOTS 4096
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t predictor;   // PredictorKind the states were built by
+    uint32_t state_size;  // Predictor state bytes per record
+    uint32_t record_size;
+    uint64_t slot_count;  // Always a power of two
+    uint64_t used;        // Slots holding a command, only used to decide when to grow
+} HistoryHeader;
+
+typedef struct {
+    uint32_t sequence;  // Odd while the record is being written
+    uint32_t length;    // Command length, 0 for a slot never used
+    uint64_t hash;
+    uint64_t predicted_burst_time;
+    uint64_t execution_count;
+    char command[HISTORY_COMMAND_MAX];
+    // Followed by state_size bytes of predictor state
+} HistoryRecord;
+
+typedef struct {
+    int fd;
+    char path[PATH_MAX - 8];  // Leaves room for the .tmp suffix
+    HistoryHeader *header;
+    size_t map_size;
+} HistoryFile;
+
+// Order the stores to a record as written; a killed process has executed
+// every store before the point it died at, so only the compiler can reorder
+#define HISTORY_STORE_FENCE() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+
+static size_t history_record_size(uint32_t state_size) {
+    return (sizeof(HistoryRecord) + state_size + 7) & ~(size_t)7;
+}
+
+static HistoryRecord* history_record(HistoryHeader* header, uint64_t slot) {
+    return (HistoryRecord*)((char*)header + sizeof(HistoryHeader) + slot * header->record_size);
+}
+
+// Maps fd, which must already have the size for slot_count records
+static HistoryHeader* history_map(int fd, size_t size) {
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return map == MAP_FAILED ? NULL : (HistoryHeader*)map;
+}
+
+// Probes for command. Returns its slot, or the empty slot it would go in.
+static uint64_t history_probe(HistoryHeader* header, const char* command, uint64_t hash, size_t length) {
+    uint64_t mask = header->slot_count - 1;
+    uint64_t slot = hash & mask;
+    while (1) {
+        HistoryRecord* record = history_record(header, slot);
+        if (record->length == 0 && record->sequence == 0) {
+            return slot;
+        }
+        if (record->hash == hash && record->length == length && memcmp(record->command, command, length) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+// Writes a record, marking it torn for the duration
+static void history_write(HistoryHeader* header, uint64_t slot, const char* command, uint64_t hash, size_t length,
+                          uint64_t predicted, uint64_t count, const void* state) {
+    HistoryRecord* record = history_record(header, slot);
+    uint32_t sequence = record->sequence | 1;
+    record->sequence = sequence;
+    HISTORY_STORE_FENCE();
+    if (record->length == 0) {
+        memcpy(record->command, command, length);
+        record->hash = hash;
+        record->length = length;
+    }
+    record->predicted_burst_time = predicted;
+    record->execution_count = count;
+    if (header->state_size > 0) {
+        if (state != NULL) {
+            memcpy(record + 1, state, header->state_size);
+        } else {
+            memset(record + 1, 0, header->state_size);
+        }
+    }
+    HISTORY_STORE_FENCE();
+    record->sequence = sequence + 1;
+}
+
+// Creates path holding every intact record of old (if any) in a table of
+// slot_count slots, then renames it over the current file and maps it.
+// Without an old table, path is only created if it still does not exist.
+// Predictor states are kept only when the layout is unchanged.
+static int history_rebuild(HistoryFile* file, HistoryHeader* old, uint64_t slot_count, uint32_t predictor, uint32_t state_size) {
+    char tmp_path[PATH_MAX];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", file->path);
+    int fd = open(tmp_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd >= 0 && flock(fd, LOCK_EX | LOCK_NB) < 0) {
+        fprintf(stderr, "%s: in use by another scheduler\n", file->path);  // It is building a table too
+        close(fd);
+        return -1;
+    }
+    size_t record_size = history_record_size(state_size);
+    size_t size = sizeof(HistoryHeader) + slot_count * record_size;
+    if (fd < 0 || ftruncate(fd, 0) < 0 || ftruncate(fd, size) < 0) {
+        perror("Error creating history file");
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    HistoryHeader* header = history_map(fd, size);
+    if (header == NULL) {
+        perror("Error mapping history file");
+        close(fd);
+        return -1;
+    }
+    memcpy(header->magic, HISTORY_MAGIC, sizeof(header->magic));
+    header->version = HISTORY_VERSION;
+    header->predictor = predictor;
+    header->state_size = state_size;
+    header->record_size = record_size;
+    header->slot_count = slot_count;
+
+    uint64_t used = 0;
+    bool keep_states = old != NULL && old->predictor == predictor && old->state_size == state_size;
+    for (uint64_t i = 0; old != NULL && i < old->slot_count; i++) {
+        HistoryRecord* record = history_record(old, i);
+        if (record->length == 0 || (record->sequence & 1)) {
+            continue;  // Empty or torn
+        }
+        uint64_t slot = history_probe(header, record->command, record->hash, record->length);
+        history_write(header, slot, record->command, record->hash, record->length,
+                      record->predicted_burst_time, record->execution_count, keep_states ? (void*)(record + 1) : NULL);
+        used++;
+    }
+    header->used = used;
+
+    // A new file is linked rather than renamed, so that it never replaces
+    // one another scheduler created in the meantime
+    bool published = msync(header, size, MS_SYNC) == 0 &&
+                     (old != NULL ? rename(tmp_path, file->path) == 0
+                                  : link(tmp_path, file->path) == 0 && unlink(tmp_path) == 0);
+    if (!published) {
+        if (errno == EEXIST) {
+            fprintf(stderr, "%s: in use by another scheduler\n", file->path);
+        } else {
+            perror("Error replacing history file");
+        }
+        munmap(header, size);
+        unlink(tmp_path);
+        close(fd);
+        return -1;
+    }
+    if (old != NULL) {
+        munmap(old, file->map_size);
+        close(file->fd);
+    }
+    file->fd = fd;
+    file->header = header;
+    file->map_size = size;
+    return 0;
+}
+
+void close_history_file(HistoryFile* file) {
+    if (file->header != NULL) {
+        munmap(file->header, file->map_size);
+        close(file->fd);
+        file->header = NULL;
+    }
+}
+
+// Opens or creates the history file at path for the given predictor layout.
+// Fails if another scheduler has it open.
+int open_history_file(HistoryFile* file, const char* path, uint32_t predictor, uint32_t state_size) {
+    memset(file, 0, sizeof(HistoryFile));
+    if (strlen(path) >= sizeof(file->path)) {
+        fprintf(stderr, "History file path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(file->path, path);
+
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return history_rebuild(file, NULL, HISTORY_INITIAL_SLOTS, predictor, state_size);
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+        fprintf(stderr, "%s: in use by another scheduler\n", path);
+        close(fd);
+        return -1;
+    }
+
+    struct stat st;
+    HistoryHeader header;
+    if (fstat(fd, &st) < 0 || pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        memcmp(header.magic, HISTORY_MAGIC, sizeof(header.magic)) != 0 || header.version != HISTORY_VERSION ||
+        header.slot_count == 0 || (header.slot_count & (header.slot_count - 1)) != 0 ||
+        header.record_size != history_record_size(header.state_size) ||
+        (uint64_t)st.st_size != sizeof(HistoryHeader) + header.slot_count * header.record_size) {
+        fprintf(stderr, "%s: not a scheduler history file\n", path);
+        close(fd);
+        return -1;
+    }
+    file->fd = fd;
+    file->map_size = st.st_size;
+    file->header = history_map(fd, st.st_size);
+    if (file->header == NULL) {
+        perror("Error mapping history file");
+        close(fd);
+        return -1;
+    }
+
+    if (header.predictor != predictor || header.state_size != state_size) {
+        // Another predictor wrote the states; keep the predictions only
+        if (history_rebuild(file, file->header, header.slot_count, predictor, state_size) < 0) {
+            close_history_file(file);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Reads the stored history of command. Returns false when there is none,
+// leaving the outputs untouched.
+bool history_file_load(HistoryFile* file, const char* command, uint64_t* predicted, uint64_t* count, void* state) {
+    size_t length = strlen(command);
+    if (file->header == NULL || length == 0 || length > HISTORY_COMMAND_MAX) {
+        return false;
+    }
+    HistoryRecord* record = history_record(file->header, history_probe(file->header, command, hash_command(command), length));
+    if (record->length == 0 || (record->sequence & 1) || record->execution_count == 0) {
+        return false;
+    }
+    *predicted = record->predicted_burst_time;
+    *count = record->execution_count;
+    if (state != NULL && file->header->state_size > 0) {
+        memcpy(state, record + 1, file->header->state_size);
+    }
+    return true;
+}
+
+// Stores the history of command in place, growing the table if needed
+void history_file_store(HistoryFile* file, const char* command, uint64_t predicted, uint64_t count, const void* state) {
+    size_t length = strlen(command);
+    if (file->header == NULL || length == 0 || length > HISTORY_COMMAND_MAX) {
+        return;
+    }
+    uint64_t hash = hash_command(command);
+    uint64_t slot = history_probe(file->header, command, hash, length);
+    if (history_record(file->header, slot)->length == 0) {
+        // Keep the load factor at or below three quarters
+        if (4 * (file->header->used + 1) > 3 * file->header->slot_count) {
+            HistoryHeader* header = file->header;
+            if (history_rebuild(file, header, header->slot_count * 2, header->predictor, header->state_size) < 0) {
+                return;
+            }
+            slot = history_probe(file->header, command, hash, length);
+        }
+        history_write(file->header, slot, command, hash, length, predicted, count, state);
+        file->header->used++;
+        return;
+    }
+    history_write(file->header, slot, command, hash, length, predicted, count, state);
+}
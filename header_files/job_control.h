@@ -0,0 +1,179 @@
+#pragma once
+
+// Job control shared by every scheduler. Each job is launched as the leader
+// of its own process group, so stopping, resuming or killing a job reaches
+// every process its command started, not just the /bin/sh wrapper.
+//
+// Set SCHEDULER_CGROUP=<dir> to a cgroup v2 directory the scheduler may
+// write to, and each job also gets a leaf cgroup there, job-<pid>. Jobs are
+// then frozen and thawed through cgroup.freeze, which also catches processes
+// that moved to another process group. The process group is signalled as
+// well, since a job only enters its cgroup once it has started and the
+// processes it started before that stay outside.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "clock.h"
+
+// Longest a stop waits for the job's cgroup to report it is frozen
+#define JOB_FREEZE_TIMEOUT_MS 100
+
+char job_cgroup_root[PATH_MAX - 64];  // Leaves room for /job-<pid>/<control file>
+bool job_cgroups = false;  // Jobs get a leaf cgroup under job_cgroup_root
+pthread_once_t job_control_once = PTHREAD_ONCE_INIT;
+
+// Reads SCHEDULER_CGROUP, once per run
+static void job_control_init() {
+    const char* root = getenv("SCHEDULER_CGROUP");
+    if (root == NULL || root[0] == '\0') {
+        return;
+    }
+    char procs[PATH_MAX];
+    snprintf(procs, sizeof(procs), "%s/cgroup.procs", root);
+    if (strlen(root) >= sizeof(job_cgroup_root) || access(procs, W_OK) != 0) {
+        fprintf(stderr, "%s: not a writable cgroup v2 directory, using process groups\n", root);
+        return;
+    }
+    strcpy(job_cgroup_root, root);
+    job_cgroups = true;
+}
+
+// Writes value to one control file of the job's leaf cgroup
+static int job_cgroup_write(pid_t pid, const char* file, const char* value) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/job-%d/%s", job_cgroup_root, (int)pid, file);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t written = write(fd, value, strlen(value));
+    close(fd);
+    return written < 0 ? -1 : 0;
+}
+
+// Moves a just-launched job into a leaf cgroup of its own. Processes the
+// job started before the move stay outside it, and are only reached
+// through the process group.
+void job_attach(pid_t pid) {
+    pthread_once(&job_control_once, job_control_init);
+    if (!job_cgroups) {
+        return;
+    }
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/job-%d", job_cgroup_root, (int)pid);
+    if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+        return;
+    }
+    char value[32];
+    snprintf(value, sizeof(value), "%d", (int)pid);
+    if (job_cgroup_write(pid, "cgroup.procs", value) < 0) {
+        rmdir(path);
+    }
+}
+
+// Waits until cgroup.events reports the job's cgroup as frozen, since
+// writing cgroup.freeze only starts freezing it. Gives up after
+// JOB_FREEZE_TIMEOUT_MS.
+static void job_cgroup_wait_frozen(pid_t pid) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/job-%d/cgroup.events", job_cgroup_root, (int)pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    uint64_t deadline = clock_ns() + JOB_FREEZE_TIMEOUT_MS * NS_PER_MS;
+    char events[256];
+    ssize_t length;
+    while ((length = pread(fd, events, sizeof(events) - 1, 0)) > 0) {
+        events[length] = '\0';
+        uint64_t now = clock_ns();
+        if (strstr(events, "frozen 1") != NULL || now >= deadline) {
+            break;
+        }
+        // The file signals a change with POLLPRI
+        struct pollfd changed = {.fd = fd, .events = POLLPRI};
+        poll(&changed, 1, (int)((deadline - now) / NS_PER_MS) + 1);
+    }
+    close(fd);
+}
+
+// Stops every process of the job, and returns once its cgroup is frozen
+void job_stop(pid_t pid) {
+    if (job_cgroups && job_cgroup_write(pid, "cgroup.freeze", "1") == 0) {
+        job_cgroup_wait_frozen(pid);
+    }
+    killpg(pid, SIGSTOP);
+}
+
+// Resumes every process of the job. SIGCONT goes first, so that a SIGSTOP
+// still pending in a frozen process is dropped before it thaws.
+void job_resume(pid_t pid) {
+    killpg(pid, SIGCONT);
+    if (job_cgroups) {
+        job_cgroup_write(pid, "cgroup.freeze", "0");
+    }
+}
+
+// Restricts every thread of every process in the job's process group to set.
+// Returns -1 when not even the leader could be moved.
+int job_set_affinity(pid_t pid, const cpu_set_t* set) {
+    int pinned = -1;
+    DIR* proc = opendir("/proc");
+    if (proc == NULL) {
+        return sched_setaffinity(pid, sizeof(*set), set);
+    }
+    struct dirent* entry;
+    while ((entry = readdir(proc)) != NULL) {
+        pid_t member = (pid_t)atoi(entry->d_name);
+        if (member <= 0 || getpgid(member) != pid) {
+            continue;
+        }
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/task", (int)member);
+        DIR* tasks = opendir(path);
+        if (tasks == NULL) {
+            continue;
+        }
+        struct dirent* task;
+        while ((task = readdir(tasks)) != NULL) {
+            pid_t tid = (pid_t)atoi(task->d_name);
+            if (tid > 0 && sched_setaffinity(tid, sizeof(*set), set) == 0 && member == pid) {
+                pinned = 0;
+            }
+        }
+        closedir(tasks);
+    }
+    closedir(proc);
+    return pinned;
+}
+
+// Kills every process of the job, stopped or frozen ones included
+void job_kill(pid_t pid) {
+    if (job_cgroups) {
+        job_cgroup_write(pid, "cgroup.kill", "1");
+    }
+    killpg(pid, SIGKILL);
+}
+
+// Removes the job's leaf cgroup once the job has been reaped. The leaf is
+// left behind if the command left processes running in it.
+void job_release(pid_t pid) {
+    if (!job_cgroups || pid <= 0) {
+        return;
+    }
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/job-%d", job_cgroup_root, (int)pid);
+    rmdir(path);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// Job launcher. Commands are started with posix_spawn, which avoids copying
+// the scheduler's page tables the way fork() does. Commands without shell
+// syntax are split on whitespace and executed directly, skipping the extra
+// /bin/sh process; everything else still goes through /bin/sh -c. Every
+// job leads a process group of its own, see job_control.h.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <signal.h>
+#include <spawn.h>
+#include <time.h>
+#include <sys/types.h>
+#include "clock.h"
+#include "job_control.h"
+
+extern char **environ;
+
+#define LAUNCH_MAX_ARGS 64
+
+// Characters that need a shell to interpret them
+#define SHELL_METACHARACTERS "|&;<>()$`\\\"'*?[]#~={}%!\n"
+
+// Shell builtins and keywords, which have no executable of their own
+const char* shell_words[] = {
+    "cd", "exit", "export", "unset", "set", "alias", "unalias", "source", ".",
+    "eval", "exec", "read", "ulimit", "umask", "wait", "trap", "shift",
+    "return", "break", "continue", "local", "readonly", "times", "type",
+    "hash", "getopts", "command", "jobs", "fg", "bg",
+    "if", "then", "else", "elif", "fi", "for", "while", "until", "do",
+    "done", "case", "esac", "function", NULL
+};
+
+// Splits command into argv inside buffer. Returns false when the command
+// needs /bin/sh: shell syntax, a builtin, or too many arguments.
+bool split_simple_command(const char* command, char* buffer, size_t size, char* argv[]) {
+    if (strpbrk(command, SHELL_METACHARACTERS) != NULL || strlen(command) >= size) {
+        return false;
+    }
+    strcpy(buffer, command);
+
+    int argc = 0;
+    char* save = NULL;
+    for (char* token = strtok_r(buffer, " \t", &save); token != NULL; token = strtok_r(NULL, " \t", &save)) {
+        if (argc == LAUNCH_MAX_ARGS) {
+            return false;
+        }
+        argv[argc++] = token;
+    }
+    argv[argc] = NULL;
+    if (argc == 0) {
+        return false;
+    }
+    for (int i = 0; shell_words[i] != NULL; i++) {
+        if (strcmp(argv[0], shell_words[i]) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Starts command and returns its pid, or -1 if it could not be started.
+// The time spent launching, in ns, is stored in *launch_latency when not NULL.
+pid_t launch_command(const char* command, uint64_t* launch_latency) {
+    uint64_t start = clock_ns();
+
+    char buffer[1024];
+    char* argv[LAUNCH_MAX_ARGS + 1];
+    char* shell_argv[] = {"/bin/sh", "-c", (char*)command, NULL};
+    bool direct = split_simple_command(command, buffer, sizeof(buffer), argv);
+
+    // Children start with default signal handling and nothing blocked
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &mask);
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+    pid_t pid;
+    int err = direct ? posix_spawnp(&pid, argv[0], NULL, &attr, argv, environ)
+                     : posix_spawn(&pid, shell_argv[0], NULL, &attr, shell_argv, environ);
+    posix_spawnattr_destroy(&attr);
+    if (err == 0) {
+        job_attach(pid);
+    }
+
+    if (launch_latency != NULL) {
+        *launch_latency = clock_ns() - start;
+    }
+    if (err != 0) {
+        fprintf(stderr, "%s: %s\n", command, strerror(err));
+        return -1;
+    }
+    return pid;
+}
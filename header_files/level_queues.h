@@ -0,0 +1,122 @@
+#pragma once
+
+// Priority levels of the MLFQ schedulers: one run queue per level and a
+// bitmap of the levels that hold a job. Level 0 is the highest priority, so
+// the next job to run is at the lowest set bit, found with a single
+// count-trailing-zeros whatever the number of levels.
+//
+// Three levels with the quanta given on the command line are used by
+// default. Set SCHEDULER_MLFQ_LEVELS=<n> for n levels (up to 64) whose quanta
+// run linearly from quantum0 through quantum1 to quantum2, or list them
+// in ms as SCHEDULER_MLFQ_QUANTA=<q0>,<q1>,...
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "run_queue.h"
+
+#define MLFQ_MAX_LEVELS 64
+
+typedef struct {
+    Queue queues[MLFQ_MAX_LEVELS];
+    uint64_t ready;  // Bit q is set while queues[q] holds a job
+    int count;
+} LevelQueues;
+
+void init_level_queues(LevelQueues* levels, int count) {
+    for (int q = 0; q < MLFQ_MAX_LEVELS; q++) {
+        levels->queues[q] = (Queue){NULL, NULL, 0};
+    }
+    levels->ready = 0;
+    levels->count = count;
+}
+
+void push_level(LevelQueues* levels, int level, Process* process) {
+    enqueue(&levels->queues[level], process);
+    levels->ready |= UINT64_C(1) << level;
+}
+
+// Takes the first job of the highest non-empty level, storing that level in
+// *level. Returns NULL when every level is empty.
+Process* pop_highest(LevelQueues* levels, int* level) {
+    if (levels->ready == 0) {
+        return NULL;
+    }
+    int q = __builtin_ctzll(levels->ready);
+    Process* process = dequeue(&levels->queues[q]);
+    if (levels->queues[q].head == NULL) {
+        levels->ready &= ~(UINT64_C(1) << q);
+    }
+    *level = q;
+    return process;
+}
+
+// Moves every job to level 0, lower levels behind higher ones
+void boost_levels(LevelQueues* levels) {
+    uint64_t lower = levels->ready & ~UINT64_C(1);
+    while (lower != 0) {
+        int q = __builtin_ctzll(lower);
+        splice_queue(&levels->queues[0], &levels->queues[q]);
+        lower &= lower - 1;
+    }
+    if (levels->ready != 0) {
+        levels->ready = 1;
+    }
+}
+
+// Performs priority boost
+void boost_priorities(LevelQueues* levels, uint64_t* last_boost_time, uint64_t current_time){
+    boost_levels(levels);  // Move processes to the highest priority queue
+    *last_boost_time = current_time;
+}
+
+// Fills quanta[] (ms, one per level) from the environment, see above.
+// Returns the number of levels.
+int mlfq_levels_from_env(int quanta[], int quantum0, int quantum1, int quantum2) {
+    const char* list = getenv("SCHEDULER_MLFQ_QUANTA");
+    if (list != NULL && list[0] != '\0') {
+        int count = 0;
+        const char* s = list;
+        while (1) {
+            char* end;
+            long quantum = strtol(s, &end, 10);
+            if (end == s || quantum <= 0 || count == MLFQ_MAX_LEVELS || (*end != ',' && *end != '\0')) {
+                count = 0;
+                break;
+            }
+            quanta[count++] = (int)quantum;
+            if (*end == '\0') break;
+            s = end + 1;
+        }
+        if (count > 0) {
+            return count;
+        }
+        fprintf(stderr, "Ignoring SCHEDULER_MLFQ_QUANTA=%s, expected 1 to %d positive quanta in ms\n", list, MLFQ_MAX_LEVELS);
+    }
+
+    int count = 3;
+    const char* levels = getenv("SCHEDULER_MLFQ_LEVELS");
+    if (levels != NULL && levels[0] != '\0') {
+        int n = atoi(levels);
+        if (n >= 2 && n <= MLFQ_MAX_LEVELS && quantum0 > 0 && quantum1 > 0 && quantum2 > 0) {
+            count = n;
+        } else {
+            fprintf(stderr, "Ignoring SCHEDULER_MLFQ_LEVELS=%s, expected 2 to %d levels and positive quanta\n", levels, MLFQ_MAX_LEVELS);
+        }
+    }
+    if (count == 3) {
+        quanta[0] = quantum0;
+        quanta[1] = quantum1;
+        quanta[2] = quantum2;
+        return count;
+    }
+    // Level q sits at 2q/(count-1) on the line quantum0 -> quantum1 -> quantum2
+    for (int q = 0; q < count; q++) {
+        int64_t step = 2 * q, span = count - 1;
+        int64_t from = (step <= span) ? quantum0 : quantum1;
+        int64_t to = (step <= span) ? quantum1 : quantum2;
+        int64_t offset = (step <= span) ? step : step - span;
+        quanta[q] = (int)(from + ((to - from) * offset + span / 2) / span);
+    }
+    return count;
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+// Self-tuning MLFQ parameters. The tuner watches a window of slices and the
+// response times of the jobs started in it, then retunes the per-level
+// quanta and the boost interval:
+//
+// - Above the last level, a quantum should just cover the jobs that finish
+//   there while longer ones are demoted. If 80% of the jobs finishing at a
+//   level needed less than 3/4 of its quantum, the quantum moves halfway
+//   towards that length plus a quarter. If they needed more than 90% of
+//   it, jobs are only just making it and the quantum grows by a quarter.
+//   The last level only sees the remainders of long jobs, so it is left to
+//   the next rule.
+// - When the context-switch rate is above MLFQ_TUNE_MAX_SWITCH_RATE, every
+//   quantum grows by a quarter.
+// - Boosts bring long jobs back to the top queue, where they compete with
+//   new arrivals. The boost interval grows when the mean response time is
+//   above half of it, and shrinks, for fairness to long jobs, when the
+//   response time is below an eighth of it.
+//
+// Quanta stay ordered by level and within the configured bounds. Every
+// change is logged on stderr with its trigger.
+//
+// Enable with SCHEDULER_MLFQ_TUNE=1, or give the bounds in ms as
+// SCHEDULER_MLFQ_TUNE=<min quantum>:<max quantum>:<min boost>:<max boost>.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "clock.h"
+
+#define MLFQ_TUNER_MAX_LEVELS 64
+#define MLFQ_TUNE_WINDOW 64            // Slices per tuning decision
+#define MLFQ_TUNE_MIN_SAMPLES 4        // Slices a level needs before its quantum is retuned
+#define MLFQ_TUNE_MAX_SWITCH_RATE 200  // Context switches per second
+
+typedef struct {
+    uint64_t elapsed_ns;
+    int level;
+    bool exited;
+} TunerSlice;
+
+typedef struct {
+    bool enabled;
+    int levels;
+    int min_quantum, max_quantum;  // ms
+    int min_boost, max_boost;      // ms
+
+    TunerSlice slices[MLFQ_TUNE_WINDOW];
+    int slice_count;
+    uint64_t window_start;  // Scheduler time of the window's first slice, ns
+    uint64_t response_sum;
+    int response_count;
+} MlfqTuner;
+
+// Reads SCHEDULER_MLFQ_TUNE; the tuner stays disabled when it is unset
+void mlfq_tuner_init(MlfqTuner* tuner, int levels) {
+    memset(tuner, 0, sizeof(MlfqTuner));
+    tuner->levels = levels < MLFQ_TUNER_MAX_LEVELS ? levels : MLFQ_TUNER_MAX_LEVELS;
+    tuner->min_quantum = 10;
+    tuner->max_quantum = 10000;
+    tuner->min_boost = 100;
+    tuner->max_boost = 60000;
+
+    const char* spec = getenv("SCHEDULER_MLFQ_TUNE");
+    if (spec == NULL || spec[0] == '\0' || strcmp(spec, "0") == 0) {
+        return;
+    }
+    if (strcmp(spec, "1") != 0) {
+        int min_quantum, max_quantum, min_boost, max_boost;
+        if (sscanf(spec, "%d:%d:%d:%d", &min_quantum, &max_quantum, &min_boost, &max_boost) != 4 ||
+            min_quantum <= 0 || min_quantum > max_quantum || min_boost <= 0 || min_boost > max_boost) {
+            fprintf(stderr, "Ignoring SCHEDULER_MLFQ_TUNE=%s, expected 1 or <min quantum>:<max quantum>:<min boost>:<max boost>\n", spec);
+            return;
+        }
+        tuner->min_quantum = min_quantum;
+        tuner->max_quantum = max_quantum;
+        tuner->min_boost = min_boost;
+        tuner->max_boost = max_boost;
+    }
+    tuner->enabled = true;
+}
+
+// Records the response time of a job that just got its first slice
+void mlfq_tuner_response(MlfqTuner* tuner, uint64_t response_ns) {
+    if (tuner->enabled) {
+        tuner->response_sum += response_ns;
+        tuner->response_count++;
+    }
+}
+
+static int mlfq_tuner_clamp(int value, int min, int max) {
+    return value < min ? min : value > max ? max : value;
+}
+
+static void mlfq_tuner_set(int* value, int new_value, const char* name, int level, const char* trigger) {
+    if (new_value == *value) {
+        return;
+    }
+    if (level >= 0) {
+        fprintf(stderr, "MLFQ tune: quantum%d %d -> %d ms (%s)\n", level, *value, new_value, trigger);
+    } else {
+        fprintf(stderr, "MLFQ tune: %s %d -> %d ms (%s)\n", name, *value, new_value, trigger);
+    }
+    *value = new_value;
+}
+
+static int compare_tuner_lengths(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Retunes quanta[] and *boost_time from the finished window
+static void mlfq_tuner_decide(MlfqTuner* tuner, uint64_t now, int quanta[], int* boost_time) {
+    char trigger[128];
+    int tuned[MLFQ_TUNER_MAX_LEVELS];
+    for (int q = 0; q < tuner->levels - 1; q++) {
+        tuned[q] = quanta[q];
+        uint64_t lengths[MLFQ_TUNE_WINDOW];
+        int count = 0, expired = 0;
+        for (int i = 0; i < tuner->slice_count; i++) {
+            if (tuner->slices[i].level != q) continue;
+            if (tuner->slices[i].exited) {
+                lengths[count++] = tuner->slices[i].elapsed_ns;
+            } else {
+                expired++;
+            }
+        }
+        if (count < MLFQ_TUNE_MIN_SAMPLES) {
+            continue;
+        }
+        qsort(lengths, count, sizeof(uint64_t), compare_tuner_lengths);
+        int target = (int)((lengths[(4 * count + 4) / 5 - 1] + NS_PER_MS - 1) / NS_PER_MS);
+        snprintf(trigger, sizeof(trigger), "80%% of %d jobs finishing at level %d needed %d ms, %d more were demoted",
+                 count, q, target, expired);
+        if (10 * target > 9 * quanta[q]) {
+            tuned[q] = quanta[q] + (quanta[q] + 3) / 4;
+        } else if (4 * target < 3 * quanta[q]) {
+            tuned[q] = (quanta[q] + target + target / 4) / 2;  // Move halfway, to damp oscillation
+        }
+        tuned[q] = mlfq_tuner_clamp(tuned[q], tuner->min_quantum, tuner->max_quantum);
+        mlfq_tuner_set(&quanta[q], tuned[q], NULL, q, trigger);
+    }
+
+    uint64_t window_ns = now - tuner->window_start;
+    double switch_rate = window_ns ? tuner->slice_count * (double)NS_PER_SEC / window_ns : 0;
+    if (switch_rate > MLFQ_TUNE_MAX_SWITCH_RATE) {
+        snprintf(trigger, sizeof(trigger), "%.0f context switches/s, above %d/s", switch_rate, MLFQ_TUNE_MAX_SWITCH_RATE);
+        for (int q = 0; q < tuner->levels; q++) {
+            int grown = mlfq_tuner_clamp(quanta[q] + (quanta[q] + 3) / 4, tuner->min_quantum, tuner->max_quantum);
+            mlfq_tuner_set(&quanta[q], grown, NULL, q, trigger);
+        }
+    }
+
+    // Lower levels never get a shorter quantum than higher ones
+    for (int q = 1; q < tuner->levels; q++) {
+        if (quanta[q] < quanta[q - 1]) {
+            snprintf(trigger, sizeof(trigger), "kept at least quantum%d", q - 1);
+            mlfq_tuner_set(&quanta[q], quanta[q - 1], NULL, q, trigger);
+        }
+    }
+
+    if (tuner->response_count > 0) {
+        uint64_t mean_response = tuner->response_sum / tuner->response_count / NS_PER_MS;
+        int boost = *boost_time;
+        if (mean_response * 2 > (uint64_t)*boost_time) {
+            boost = *boost_time + (*boost_time + 3) / 4;
+        } else if (mean_response * 8 < (uint64_t)*boost_time) {
+            boost = *boost_time - *boost_time / 4;
+        }
+        snprintf(trigger, sizeof(trigger), "mean response time %lu ms over %d jobs", mean_response, tuner->response_count);
+        mlfq_tuner_set(boost_time, mlfq_tuner_clamp(boost, tuner->min_boost, tuner->max_boost), "boostTime", -1, trigger);
+    }
+}
+
+// Records a slice that ran at level and ended at scheduler time now. Once
+// a window is full, retunes quanta[] (ms, one per level) and *boost_time.
+void mlfq_tuner_slice(MlfqTuner* tuner, int level, bool exited, uint64_t elapsed_ns, uint64_t now,
+                      int quanta[], int* boost_time) {
+    if (!tuner->enabled) {
+        return;
+    }
+    if (tuner->slice_count == 0) {
+        tuner->window_start = now - elapsed_ns;
+    }
+    tuner->slices[tuner->slice_count++] = (TunerSlice){.elapsed_ns = elapsed_ns, .level = level, .exited = exited};
+    if (tuner->slice_count == MLFQ_TUNE_WINDOW) {
+        mlfq_tuner_decide(tuner, now, quanta, boost_time);
+        tuner->slice_count = 0;
+        tuner->response_sum = 0;
+        tuner->response_count = 0;
+    }
+}
@@ -0,0 +1,336 @@
+#pragma once
+
+// Multi-core dispatch for the offline schedulers. One worker thread per CPU
+// runs its own jobs, so up to num_cpus children execute at the same time.
+// Each worker owns a local run queue with FCFS, RR or MLFQ semantics, and a
+// worker that runs out of work steals a job from the busiest other worker.
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/wait.h>
+#include "process.h"
+#include "run_queue.h"
+#include "level_queues.h"
+#include "launcher.h"
+#include "slice_engine.h"
+#include "result_sink.h"
+#include "trace.h"
+
+typedef enum {
+    DISPATCH_FCFS,
+    DISPATCH_RR,
+    DISPATCH_MLFQ
+} DispatchPolicy;
+
+typedef struct Dispatcher Dispatcher;
+
+typedef struct {
+    Dispatcher *dispatcher;
+    int id;
+    int cpu;
+    pthread_t thread;
+
+    pthread_mutex_t lock;             // Guards the local queues
+    LevelQueues levels;               // RR and FCFS only use level 0
+    atomic_int queued;                // Jobs in the local queues, read by thieves
+    uint64_t last_boost_time;
+} Worker;
+
+struct Dispatcher {
+    DispatchPolicy policy;
+    int quantum[MLFQ_MAX_LEVELS];
+    int boostTime;
+
+    Worker *workers;
+    int num_workers;
+    int n;
+    atomic_int completed;
+    uint64_t epoch;  // Dispatch start, all job times are relative to it
+
+    pthread_mutex_t output_lock;  // Guards both logs
+    ResultSink csv;
+    ContextSwitchLog context_switches;
+
+    pthread_mutex_t idle_lock;  // Idle workers wait here for work to appear
+    pthread_cond_t idle_cond;
+};
+
+// Adds a job to a worker's local queue at the given level
+void worker_push(Worker* worker, Process* process, int level) {
+    pthread_mutex_lock(&worker->lock);
+    push_level(&worker->levels, level, process);
+    atomic_fetch_add(&worker->queued, 1);
+    pthread_mutex_unlock(&worker->lock);
+}
+
+// Takes the highest-priority local job, storing its level in *level
+Process* worker_pop(Worker* worker, int* level) {
+    pthread_mutex_lock(&worker->lock);
+    Process* process = pop_highest(&worker->levels, level);
+    if (process != NULL) {
+        atomic_fetch_sub(&worker->queued, 1);
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return process;
+}
+
+// Steals a job from the worker with the most queued jobs
+Process* worker_steal(Worker* thief, int* level) {
+    Dispatcher* d = thief->dispatcher;
+    Worker* victim = NULL;
+    int most = 0;
+    for (int w = 0; w < d->num_workers; w++) {
+        int queued = atomic_load(&d->workers[w].queued);
+        if (&d->workers[w] != thief && queued > most) {
+            most = queued;
+            victim = &d->workers[w];
+        }
+    }
+    return victim ? worker_pop(victim, level) : NULL;
+}
+
+// Wakes idle workers after a job was queued or the run finished
+void dispatcher_notify(Dispatcher* d) {
+    pthread_mutex_lock(&d->idle_lock);
+    pthread_cond_broadcast(&d->idle_cond);
+    pthread_mutex_unlock(&d->idle_lock);
+}
+
+// Restricts job pid and its whole process group (0 for the worker thread
+// itself) to the worker's CPU
+void worker_pin(Worker* worker, pid_t pid) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(worker->cpu, &set);
+    if (pid == 0) {
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    } else {
+        job_set_affinity(pid, &set);
+    }
+}
+
+// Runs one slice of a job on this worker, then requeues or retires it
+void worker_run(Worker* worker, Process* process, int level, bool stolen, SliceEngine* engine) {
+    Dispatcher* d = worker->dispatcher;
+
+    if (stolen && process->started && process->pid > 0) {
+        worker_pin(worker, process->pid);  // Follow the job to its new CPU
+    }
+    if (!process->started) {
+        process->start_time = clock_ns() - d->epoch;
+        process->response_time = process->start_time - process->arrival_time;
+        process->started = true;
+        // Children inherit the worker thread's CPU affinity
+        process->pid = launch_command(process->command, &process->launch_latency);
+        if (process->pid < 0) {
+            process->error = true;
+        }
+    }
+
+    uint64_t context_switch_start = clock_ns() - d->epoch;
+    if (process->pid > 0) {
+        int status = 0;
+        bool exited = true;
+        uint64_t burst_time;
+        if (d->policy == DISPATCH_FCFS) {
+            struct rusage usage;
+            wait4(process->pid, &status, 0, &usage);
+            job_release(process->pid);
+            burst_time = clock_ns() - d->epoch - context_switch_start;
+            process->cpu_time = rusage_cpu_ns(&usage);
+        } else {
+            SliceResult slice = run_slice(engine, process->pid, d->quantum[level]);
+            exited = slice.outcome == SLICE_EXITED;
+            status = slice.status;
+            burst_time = slice.elapsed_ns;
+            process->cpu_time = slice.cpu_ns;
+        }
+        process->burst_time += burst_time;
+        if (exited) {
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                process->finished = true;
+            } else {
+                process->error = true;
+            }
+        }
+    }
+    uint64_t context_switch_end = clock_ns() - d->epoch;
+
+    if (process->finished || process->error) {
+        process->pid = 0;
+        process->completion_time = context_switch_end;
+        process->turnaround_time = process->completion_time - process->arrival_time;
+        process->waiting_time = process->turnaround_time - process->burst_time;
+    } else {
+        // Drop the priority under MLFQ, RR keeps everything on level 0
+        int next = (d->policy == DISPATCH_MLFQ && level < worker->levels.count - 1) ? level + 1 : level;
+        worker_push(worker, process, next);
+        dispatcher_notify(d);
+    }
+
+    pthread_mutex_lock(&d->output_lock);
+    if (process->finished || process->error) {
+        write_to_csv(&d->csv, *process);
+    }
+    TraceReason reason = (process->finished || process->error) ? TRACE_EXITED : TRACE_EXPIRED;
+    log_context_switch(&d->context_switches, process, worker->id, level, reason, context_switch_start, context_switch_end);
+    pthread_mutex_unlock(&d->output_lock);
+
+    if (process->finished || process->error) {
+        if (atomic_fetch_add(&d->completed, 1) + 1 == d->n) {
+            dispatcher_notify(d);
+        }
+    }
+}
+
+// Moves every local job back to the top level
+void worker_boost(Worker* worker) {
+    pthread_mutex_lock(&worker->lock);
+    boost_levels(&worker->levels);
+    pthread_mutex_unlock(&worker->lock);
+    worker->last_boost_time = clock_ns();
+
+    Dispatcher* d = worker->dispatcher;
+    pthread_mutex_lock(&d->output_lock);
+    log_priority_boost(&d->context_switches, worker->id, worker->last_boost_time - d->epoch);
+    pthread_mutex_unlock(&d->output_lock);
+}
+
+void* worker_main(void* arg) {
+    Worker* worker = (Worker*)arg;
+    Dispatcher* d = worker->dispatcher;
+    SliceEngine engine;
+    if (slice_engine_init(&engine) < 0) {
+        return NULL;  // The other workers will steal this worker's jobs
+    }
+    worker->last_boost_time = clock_ns();
+    worker_pin(worker, 0);
+
+    while (atomic_load(&d->completed) < d->n) {
+        if (d->policy == DISPATCH_MLFQ && clock_ns() - worker->last_boost_time >= d->boostTime * NS_PER_MS) {
+            worker_boost(worker);
+        }
+
+        int level = 0;
+        bool stolen = false;
+        Process* process = worker_pop(worker, &level);
+        if (process == NULL) {
+            process = worker_steal(worker, &level);
+            stolen = process != NULL;
+        }
+        if (process != NULL) {
+            worker_run(worker, process, level, stolen, &engine);
+            continue;
+        }
+
+        // Nothing to run anywhere, sleep until a job is requeued or everything completed
+        pthread_mutex_lock(&d->idle_lock);
+        if (atomic_load(&d->completed) < d->n) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 50 * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&d->idle_cond, &d->idle_lock, &deadline);
+        }
+        pthread_mutex_unlock(&d->idle_lock);
+    }
+
+    slice_engine_destroy(&engine);
+    return NULL;
+}
+
+// Fills cpus with the CPUs this process may run on (taskset, cpusets) and
+// returns how many there are
+int allowed_cpus(int cpus[CPU_SETSIZE]) {
+    cpu_set_t allowed;
+    int count = 0;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus[count++] = cpu;
+            }
+        }
+    }
+    if (count == 0) {
+        cpus[count++] = 0;
+    }
+    return count;
+}
+
+// Runs the jobs on num_cpus workers (all allowed CPUs when num_cpus <= 0).
+// The jobs' arrival times are treated as 0 for the run and restored after.
+// RR uses quantum0 for every slice; FCFS ignores the quanta and boostTime.
+void MultiCoreScheduler(Process p[], int n, int num_cpus, DispatchPolicy policy, int quantum0, int quantum1, int quantum2, int boostTime) {
+    const char* filenames[] = {"result_offline_multicore_FCFS.csv", "result_offline_multicore_RR.csv", "result_offline_multicore_MLFQ.csv"};
+    Dispatcher d = {0};
+    if (open_result_sink(&d.csv, filenames[policy], RESULT_CSV_HEADER) < 0) {
+        return;
+    }
+    open_context_switch_log(&d.context_switches);
+
+    int cpus[CPU_SETSIZE];
+    int cpu_count = allowed_cpus(cpus);
+    if (num_cpus <= 0) {
+        num_cpus = cpu_count;
+    }
+    if (num_cpus > n) {
+        num_cpus = n > 0 ? n : 1;
+    }
+    d.policy = policy;
+    d.quantum[0] = quantum0;
+    int level_count = (policy == DISPATCH_MLFQ) ? mlfq_levels_from_env(d.quantum, quantum0, quantum1, quantum2) : 1;
+    d.boostTime = boostTime;
+    d.n = n;
+    d.num_workers = num_cpus;
+    d.workers = (Worker*)calloc(num_cpus, sizeof(Worker));
+    pthread_mutex_init(&d.output_lock, NULL);
+    pthread_mutex_init(&d.idle_lock, NULL);
+    pthread_cond_init(&d.idle_cond, NULL);
+
+    for (int w = 0; w < num_cpus; w++) {
+        d.workers[w].dispatcher = &d;
+        d.workers[w].id = w;
+        d.workers[w].cpu = cpus[w % cpu_count];
+        pthread_mutex_init(&d.workers[w].lock, NULL);
+        init_level_queues(&d.workers[w].levels, level_count);
+    }
+
+    // Spread the jobs over the workers in submission order. All of them
+    // arrive at the start of the run.
+    uint64_t* arrivals = (uint64_t*)malloc((n > 0 ? n : 1) * sizeof(uint64_t));
+    for (int i = 0; i < n; i++) {
+        arrivals[i] = p[i].arrival_time;
+        p[i].arrival_time = 0;
+        p[i].burst_time = 0;
+        worker_push(&d.workers[i % num_cpus], &p[i], 0);
+    }
+
+    d.epoch = clock_ns();
+    for (int w = 0; w < num_cpus; w++) {
+        pthread_create(&d.workers[w].thread, NULL, worker_main, &d.workers[w]);
+    }
+    for (int w = 0; w < num_cpus; w++) {
+        pthread_join(d.workers[w].thread, NULL);
+    }
+    for (int i = 0; i < n; i++) {
+        p[i].arrival_time = arrivals[i];
+    }
+    free(arrivals);
+
+    for (int w = 0; w < num_cpus; w++) {
+        pthread_mutex_destroy(&d.workers[w].lock);
+    }
+    pthread_mutex_destroy(&d.output_lock);
+    pthread_mutex_destroy(&d.idle_lock);
+    pthread_cond_destroy(&d.idle_cond);
+    free(d.workers);
+    close_result_sink(&d.csv);
+    close_context_switch_log(&d.context_switches);
+}
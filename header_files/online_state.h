@@ -0,0 +1,523 @@
+#pragma once
+
+// Every program includes this header before any other system header, so
+// the multi-core dispatcher's CPU affinity calls are declared whichever
+// scheduler headers a translation unit pulls in
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+// State shared by the online schedulers and the simulator: the process
+// table, input from stdin and the submission socket, job options, the
+// per-command burst history and predictions, and the SJF/SRTF ready sets.
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <stdint.h>
+#include <float.h>
+#include "process.h"
+#include "clock.h"
+#include "run_queue.h"
+#include "level_queues.h"
+#include "process_table.h"
+#include "command_table.h"
+#include "ready_heap.h"
+#include "burst_predictor.h"
+#include "history_file.h"
+#include "mlfq_tuner.h"
+#include "cfs_queue.h"
+#include "share_queue.h"
+#include "deadline_queue.h"
+#include "launcher.h"
+#include "slice_engine.h"
+#include "result_sink.h"
+#include "trace.h"
+#include "submit_server.h"
+
+
+// Stores the history of burst time, indexed by interned command id
+typedef struct {
+    uint64_t predicted_burst_time;  // From burst_predictor, valid once execution_count > 0
+    int execution_count;
+} ProcessHistory;
+
+#define INITIAL_BURST_TIME (1000 * NS_PER_MS)
+#define MAX_COMMAND_LENGTH 1024
+
+ProcessTable process_table = {0};
+int process_count = 0;  // Jobs submitted so far, numbers the arrivals
+ProcessHistory *process_history = NULL;
+int history_capacity = 0;
+// Per-command predictor state, predictor_state_size() bytes per command
+unsigned char *predictor_states = NULL;
+// Burst history kept across runs when set, by SCHEDULER_HISTORY=<file>
+HistoryFile *history_file = NULL;
+
+// Predictors learn from CPU time instead of wall time, set by SCHEDULER_PREDICT_CPU=1
+bool predict_cpu_time = false;
+
+// Socket jobs are also taken from when set, by SCHEDULER_SOCKET=<path>
+SubmitServer *submit_server = NULL;
+// False once stdin reached end of file while the socket keeps taking jobs
+bool stdin_open = true;
+
+// Ready jobs of every command in arrival order, used by SJF
+Queue *ready_jobs = NULL;
+// Commands with ready jobs, ordered by expected burst time
+ReadyHeap ready_commands = {0};
+// Ready jobs ordered by predicted remaining time, keyed by process table slot, used by SRTF
+ReadyHeap srtf_ready = {0};
+// The slots in srtf_ready of each command, as a list linked through
+// srtf_links, so a command's jobs are re-keyed without a search
+int *srtf_command_heads = NULL;  // Command id -> first slot, -1 if none
+typedef struct {
+    int prev, next;  // Slots, -1 at either end
+} SrtfLink;
+SrtfLink *srtf_links = NULL;  // Indexed by slot
+int srtf_links_capacity = 0;
+
+// Gets the input
+int get_input(char *command) {
+    if (!stdin_open) {
+        return 0;
+    }
+    fd_set readfds;
+    struct timeval timeout;
+
+    // Clear the file descriptor set
+    FD_ZERO(&readfds);
+    // Add stdin (fd 0) to the set
+    FD_SET(STDIN_FILENO, &readfds);
+
+    // Set timeout to 0 seconds, 0 microseconds (non-blocking)
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 0;
+
+    // Check if input is available
+    int ret = select(STDIN_FILENO + 1, &readfds, NULL, NULL, &timeout);
+
+    if (ret > 0 && FD_ISSET(STDIN_FILENO, &readfds)) {
+        // Input is available, fetch it using fgets
+        if (fgets(command, MAX_COMMAND_LENGTH, stdin) != NULL) {
+            // Successfully read input
+            return 1;
+        }
+    }
+    return 0;  // No input available
+}
+
+// Makes sure the history and ready jobs have a record for every interned command
+void reserve_process_history(int count) {
+    if (count <= history_capacity) {
+        return;
+    }
+    int new_capacity = history_capacity ? history_capacity : COMMAND_TABLE_INITIAL_SLOTS;
+    while (new_capacity < count) {
+        new_capacity *= 2;
+    }
+    process_history = (ProcessHistory*)realloc(process_history, sizeof(ProcessHistory) * new_capacity);
+    memset(process_history + history_capacity, 0, sizeof(ProcessHistory) * (new_capacity - history_capacity));
+    ready_jobs = (Queue*)realloc(ready_jobs, sizeof(Queue) * new_capacity);
+    memset(ready_jobs + history_capacity, 0, sizeof(Queue) * (new_capacity - history_capacity));
+    srtf_command_heads = (int*)realloc(srtf_command_heads, sizeof(int) * new_capacity);
+    memset(srtf_command_heads + history_capacity, -1, sizeof(int) * (new_capacity - history_capacity));
+    size_t state_size = predictor_state_size();
+    if (state_size > 0) {
+        predictor_states = (unsigned char*)realloc(predictor_states, state_size * new_capacity);
+        memset(predictor_states + state_size * history_capacity, 0, state_size * (new_capacity - history_capacity));
+    }
+    history_capacity = new_capacity;
+}
+
+// Frees every job, the history and the ready sets, leaving a clean state
+void free_online_state() {
+    free_command_table(&command_table);
+    free(process_history);
+    process_history = NULL;
+    history_capacity = 0;
+    free(ready_jobs);
+    ready_jobs = NULL;
+    free(srtf_command_heads);
+    srtf_command_heads = NULL;
+    free(srtf_links);
+    srtf_links = NULL;
+    srtf_links_capacity = 0;
+    free(predictor_states);
+    predictor_states = NULL;
+    free_ready_heap(&ready_commands);
+    free_ready_heap(&srtf_ready);
+    free_process_table(&process_table);
+    process_count = 0;
+}
+
+// Per-command predictor state block, NULL when the predictor keeps none
+void* predictor_state(int command_id) {
+    return predictor_states ? predictor_states + predictor_state_size() * command_id : NULL;
+}
+
+// Copies the saved history of a command into process_history
+void load_process_history(int command_id) {
+    ProcessHistory* hist = &process_history[command_id];
+    uint64_t predicted, count;
+    if (history_file_load(history_file, command_table.commands[command_id], &predicted, &count, predictor_state(command_id))) {
+        hist->predicted_burst_time = predicted;
+        hist->execution_count = count;
+    }
+}
+
+// Applies the options a job line may start with, as in "[nice=5] make",
+// "[tickets=300] make" or "[deadline=2000] make", and returns the command
+// that follows them. The deadline is in ms and relative until add_process
+// adds the arrival time.
+const char* parse_job_options(const char* line, Process* process) {
+    const char* end = strchr(line, ']');
+    if (line[0] != '[' || line[1] == ' ' || end == NULL) {
+        return line;  // No options, "[ ... ]" is the test command
+    }
+    for (const char* option = line + 1; option < end; ) {
+        const char* next = memchr(option, ',', end - option);
+        if (next == NULL) next = end;
+        const char* equals = memchr(option, '=', next - option);
+        char* value_end = NULL;
+        long value = equals ? strtol(equals + 1, &value_end, 10) : 0;
+        size_t key_length = equals ? (size_t)(equals - option) : 0;
+        bool valid = value_end == next && value_end != equals + 1;
+        if (valid && key_length == 4 && strncmp(option, "nice", 4) == 0 && value >= -20 && value <= 19) {
+            process->weight = cfs_nice_weights[value + 20];
+        } else if (valid && key_length == 7 && strncmp(option, "tickets", 7) == 0 && value > 0 && value <= MAX_TICKETS) {
+            process->tickets = value;
+        } else if (valid && key_length == 8 && strncmp(option, "deadline", 8) == 0 && value > 0) {
+            process->deadline = (uint64_t)value * NS_PER_MS;
+        } else {
+            fprintf(stderr, "Ignoring job option %.*s\n", (int)(next - option), option);
+        }
+        option = next + 1;
+    }
+    end++;
+    while (*end == ' ') end++;
+    return end;
+}
+
+// Add process to process table
+Process* add_process(const char* command, uint64_t current_time) {
+    Process* process = alloc_process(&process_table);
+    if (process == NULL) {
+        perror("Error allocating process");
+        return NULL;
+    }
+    command = parse_job_options(command, process);
+    int known_commands = command_table.count;
+    int command_id = intern_command(&command_table, command);
+    reserve_process_history(command_table.count);
+    if (command_id == known_commands && history_file != NULL) {
+        // First job of this command in this run, start from the saved history
+        load_process_history(command_id);
+    }
+    process->command = command_table.commands[command_id];
+    process->command_id = command_id;
+    process->process_id = ++process_count;
+    process->arrival_time = current_time;
+    if (process->deadline) {
+        process->deadline += current_time;
+    }
+    return process;
+}
+
+// Check is input is availabe and add it. Returns the new process, or NULL.
+Process* check_and_add_input(char *command, int *quit_func, uint64_t current_time){
+    if (!get_input(command)) {
+        // End of input behaves like quit, unless jobs can still come from the socket
+        if (stdin_open && feof(stdin)) {
+            if (submit_server == NULL) {
+                *quit_func = 1;
+            }
+            stdin_open = false;
+        }
+        return NULL;
+    }
+    // Remove newline character
+    command[strcspn(command, "\n")] = 0;
+    if (strcmp(command, "quit") == 0) {
+        *quit_func = 1;
+        return NULL;
+    }
+    return add_process(command, current_time);
+}
+
+// Adds every job submitted over the socket since the last call to arrived,
+// in submission order, and returns how many there were. A job's arrival
+// time is set back by the real time it spent waiting to be taken.
+int take_submissions(Queue* arrived, int* quit_func, uint64_t current_time) {
+    if (submit_server == NULL) {
+        return 0;
+    }
+    int count = 0;
+    uint64_t now = clock_ns();
+    Submission* submission = submit_server_take(submit_server);
+    while (submission != NULL) {
+        Submission* next = submission->next;
+        if (strcmp(submission->command, "quit") == 0) {
+            *quit_func = 1;
+        } else if (!*quit_func) {
+            uint64_t waited = now - submission->arrival_ns;
+            Process* process = add_process(submission->command, current_time > waited ? current_time - waited : 0);
+            if (process != NULL) {
+                enqueue(arrived, process);
+                count++;
+            }
+        }
+        free(submission);
+        submission = next;
+    }
+    return count;
+}
+
+// Returns the history index of a command, or -1 if it never completed
+int find_process_history(const char* command) {
+    int command_id = lookup_command(&command_table, command);
+    if (command_id == -1 || process_history[command_id].execution_count == 0) {
+        return -1;
+    }
+    return command_id;
+}
+
+// Burst a job has shown so far, as seen by the predictors
+uint64_t observed_burst_time(Process* process) {
+    return predict_cpu_time ? process->cpu_time : process->burst_time;
+}
+
+// Expected burst time of a command, INITIAL_BURST_TIME when unknown
+uint64_t expected_burst_time(int command_id) {
+    ProcessHistory* hist = &process_history[command_id];
+    return (hist->execution_count == 0) ? INITIAL_BURST_TIME : hist->predicted_burst_time;
+}
+
+// Re-keys a command in the ready heap after its jobs or estimate changed
+void refresh_ready_command(int command_id) {
+    Process* head = ready_jobs[command_id].head;
+    if (head == NULL) {
+        ready_heap_remove(&ready_commands, command_id);
+    } else {
+        // Equal estimates fall back to arrival order, like the old linear scan
+        ready_heap_update(&ready_commands, command_id, expected_burst_time(command_id), head->process_id);
+    }
+}
+
+// Makes a process eligible for SJF selection
+void add_ready_job(Process* process) {
+    enqueue(&ready_jobs[process->command_id], process);
+    refresh_ready_command(process->command_id);
+}
+
+// Feeds a completed burst to the command's predictor
+void update_process_history(int command_id, uint64_t actual_burst_time) {
+    ProcessHistory* hist = &process_history[command_id];
+    void* state = predictor_state(command_id);
+    hist->predicted_burst_time = predictor_update(state, hist->predicted_burst_time, hist->execution_count, actual_burst_time);
+    hist->execution_count++;
+    if (history_file != NULL) {
+        history_file_store(history_file, command_table.commands[command_id], hist->predicted_burst_time, hist->execution_count, state);
+    }
+    if (ready_heap_contains(&ready_commands, command_id)) {
+        refresh_ready_command(command_id);
+    }
+}
+
+// Removes and returns the ready job with the shortest expected burst, or NULL
+Process* get_shortest_job() {
+    int command_id = ready_heap_top(&ready_commands);
+    if (command_id == -1) {
+        return NULL;
+    }
+    Process* process = dequeue(&ready_jobs[command_id]);
+    refresh_ready_command(command_id);
+    return process;
+}
+
+// Shortest Remaining Time First (SRTF)
+
+// Time a job is still expected to need, based on its command's history
+uint64_t predicted_remaining_time(Process* process) {
+    uint64_t expected = expected_burst_time(process->command_id);
+    uint64_t used = observed_burst_time(process);
+    return (used < expected) ? expected - used : 0;
+}
+
+// Makes a process eligible for SRTF selection. Jobs that never ran all
+// need their command's full estimate, so they wait in the SJF per-command
+// queues; only preempted jobs get an entry of their own in srtf_ready.
+void add_srtf_job(Process* process) {
+    if (!process->started) {
+        add_ready_job(process);
+        return;
+    }
+    int slot = process->slot;
+    if (!ready_heap_contains(&srtf_ready, slot)) {
+        if (slot >= srtf_links_capacity) {
+            srtf_links_capacity = srtf_links_capacity ? srtf_links_capacity : PROCESS_CHUNK_SIZE;
+            while (srtf_links_capacity <= slot) {
+                srtf_links_capacity *= 2;
+            }
+            srtf_links = (SrtfLink*)realloc(srtf_links, sizeof(SrtfLink) * srtf_links_capacity);
+        }
+        int* head = &srtf_command_heads[process->command_id];
+        srtf_links[slot] = (SrtfLink){-1, *head};
+        if (*head != -1) {
+            srtf_links[*head].prev = slot;
+        }
+        *head = slot;
+    }
+    ready_heap_update(&srtf_ready, slot, predicted_remaining_time(process), process->process_id);
+}
+
+// Ready job with the least predicted remaining time, or NULL
+Process* peek_srtf_job() {
+    int command_id = ready_heap_top(&ready_commands);
+    int slot = ready_heap_top(&srtf_ready);
+    if (slot == -1) {
+        return command_id == -1 ? NULL : ready_jobs[command_id].head;
+    }
+    Process* preempted = process_table.all[slot];
+    if (command_id == -1) {
+        return preempted;
+    }
+    Process* fresh = ready_jobs[command_id].head;
+    uint64_t fresh_key = ready_commands.keys[command_id];
+    uint64_t preempted_key = srtf_ready.keys[slot];
+    if (fresh_key != preempted_key) {
+        return fresh_key < preempted_key ? fresh : preempted;
+    }
+    return fresh->process_id < preempted->process_id ? fresh : preempted;
+}
+
+// Removes a job returned by peek_srtf_job from the ready set
+void take_srtf_job(Process* process) {
+    if (!process->started) {
+        dequeue(&ready_jobs[process->command_id]);
+        refresh_ready_command(process->command_id);
+    } else {
+        SrtfLink link = srtf_links[process->slot];
+        if (link.prev != -1) {
+            srtf_links[link.prev].next = link.next;
+        } else {
+            srtf_command_heads[process->command_id] = link.next;
+        }
+        if (link.next != -1) {
+            srtf_links[link.next].prev = link.prev;
+        }
+        ready_heap_remove(&srtf_ready, process->slot);
+    }
+}
+
+// Re-keys the preempted jobs of a command after its history changed
+void refresh_srtf_command(int command_id) {
+    for (int slot = srtf_command_heads[command_id]; slot != -1; slot = srtf_links[slot].next) {
+        ready_heap_update(&srtf_ready, slot, predicted_remaining_time(process_table.all[slot]), srtf_ready.ties[slot]);
+    }
+}
+
+// Applies SCHEDULER_PREDICT_CPU and SCHEDULER_PREDICTOR, then opens the
+// history file given by SCHEDULER_HISTORY in *history and, unless server is
+// NULL, starts the socket given by SCHEDULER_SOCKET in *server. Returns -1
+// if one of them could not be set up.
+int start_online_services(HistoryFile* history, SubmitServer* server) {
+    // Predict from CPU demand rather than wall time when asked to
+    const char* predict = getenv("SCHEDULER_PREDICT_CPU");
+    predict_cpu_time = predict != NULL && strcmp(predict, "1") == 0;
+    if (burst_predictor_from_env() < 0) {
+        return -1;
+    }
+
+    // Start from, and keep, the burst history of earlier runs when asked to
+    const char* history_path = getenv("SCHEDULER_HISTORY");
+    if (history_path != NULL && history_path[0] != '\0') {
+        if (open_history_file(history, history_path, burst_predictor.kind, predictor_state_size()) < 0) {
+            return -1;
+        }
+        history_file = history;
+    }
+
+    // Also take jobs from submit_jobs clients when asked to
+    const char* socket_path = getenv("SCHEDULER_SOCKET");
+    if (server != NULL && socket_path != NULL && socket_path[0] != '\0') {
+        if (submit_server_start(server, socket_path) < 0) {
+            return -1;
+        }
+        submit_server = server;
+    }
+    return 0;
+}
+
+// Stops the socket and closes the history file, if they were started
+void stop_online_services() {
+    if (submit_server != NULL) {
+        submit_server_stop(submit_server);
+        submit_server = NULL;
+    }
+    if (history_file != NULL) {
+        close_history_file(history_file);
+        history_file = NULL;
+    }
+}
+
+// Blocks until input is available on stdin or the submission socket, a
+// signal arrives, or at most RESULT_SINK_FLUSH_INTERVAL_MS
+void wait_for_input() {
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    int max_fd = -1;
+    if (stdin_open) {
+        FD_SET(STDIN_FILENO, &readfds);
+        max_fd = STDIN_FILENO;
+    }
+    if (submit_server != NULL) {
+        FD_SET(submit_server->wake_fd, &readfds);
+        max_fd = (submit_server->wake_fd > max_fd) ? submit_server->wake_fd : max_fd;
+    }
+    struct timeval timeout = {.tv_sec = RESULT_SINK_FLUSH_INTERVAL_MS / 1000,
+                              .tv_usec = RESULT_SINK_FLUSH_INTERVAL_MS % 1000 * 1000};
+    select(max_fd + 1, &readfds, NULL, NULL, &timeout);
+}
+
+// Multi-level Feedback Queue (MLFQ)
+
+// gets the priority: the first level whose quantum covers the predicted burst
+int get_priority(Process p, const int quanta[], int levels){
+    ProcessHistory* hist = &process_history[p.command_id];
+    if (hist->execution_count == 0) return levels / 2;
+    for (int q = 0; q < levels - 1; q++) {
+        if (hist->predicted_burst_time <= quanta[q] * NS_PER_MS) return q;
+    }
+    return levels - 1;
+}
+
+
+
+// Earliest Deadline First (EDF), see deadline_queue.h
+
+// Predicted remaining time for the EDF admission check. Commands that never
+// completed are not held against anyone, rather than assumed to need
+// INITIAL_BURST_TIME.
+uint64_t edf_predicted_time(Process* process) {
+    return process_history[process->command_id].execution_count ? predicted_remaining_time(process) : 0;
+}
+
+
+// Runs the EDF admission check on an arrived job. Returns false if the job
+// was rejected, otherwise it is now ready in edf.
+bool admit_edf_job(DeadlineQueue* edf, Process* process, Process* running, uint64_t current_time) {
+    uint64_t running_predicted = running ? edf_predicted_time(running) : 0;
+    if (!deadline_admit(edf, process->slot, process, edf_predicted_time(process), running, running_predicted, current_time)) {
+        fprintf(stderr, "Rejected %s, predicted to miss its deadline\n", process->command);
+        process->completion_time = current_time;
+        return false;
+    }
+    return true;
+}
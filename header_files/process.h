@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+// Fields are ordered by use: the ones a pick, a slice or a ready set
+// touches come first, in the first 64 bytes, and the ones only set at
+// arrival or read at completion come last. The state flags share one byte.
+typedef struct Process {
+
+    // Intrusive link used by the run queues
+    struct Process *next;
+
+    // Times are in nanoseconds on the monotonic clock
+    uint64_t burst_time;      // Wall time the job held the CPU
+    uint64_t vruntime;        // Completely fair scheduling: time held the CPU, scaled by the weight
+    uint64_t pass;            // Stride scheduling virtual time
+
+    int slot;        // Stable index in the online process table
+    int command_id;  // Interned command id, used by the online schedulers
+    int process_id;
+    pid_t pid;       // Child running the command, 0 before it is launched
+    int weight;      // Completely fair scheduling load weight, 0 for nice 0
+    int tickets;     // Proportional-share scheduling share of the CPU, 0 for DEFAULT_TICKETS
+
+    //Temporary parameters for your usage can modify them as you wish
+    bool started : 1;
+    bool finished : 1;  //If the process is finished safely
+    bool error : 1;     //If an error occurs during execution
+
+    //This will be given by the tester function this is the process command to be scheduled
+    char *command;
+
+    uint64_t deadline;        // Earliest deadline first: absolute, on the scheduler clock, 0 for none; relative to the arrival in offline job arrays
+    uint64_t cpu_time;        // User plus system CPU time the job consumed
+    uint64_t arrival_time;
+    uint64_t start_time;
+    uint64_t completion_time;
+    uint64_t turnaround_time;
+    uint64_t waiting_time;
+    uint64_t response_time;
+    uint64_t launch_latency;  // Time spent starting the command
+
+} Process;
@@ -0,0 +1,69 @@
+#pragma once
+
+// Growable process table for the online schedulers. Records are carved out
+// of an arena in fixed chunks, so a Process* stays valid for the lifetime
+// of the job and can be used as its handle. Completed records go on a free
+// list and are reused by later arrivals, which keeps memory proportional to
+// the number of live jobs.
+#include <string.h>
+#include "arena.h"
+#include "process.h"
+
+#define PROCESS_CHUNK_SIZE 256
+
+typedef struct {
+    Arena arena;
+    Process *chunk;   // Chunk currently being handed out
+    int chunk_used;
+    Process *free_list;  // Recycled records, chained through next
+
+    Process **all;    // Every record ever carved, indexed by slot
+    int allocated;
+    int all_capacity;
+    int live;         // Records currently in use
+} ProcessTable;
+
+// Returns a zeroed record, reusing a completed one when possible
+Process* alloc_process(ProcessTable* table) {
+    Process* process = table->free_list;
+    int slot;
+    if (process != NULL) {
+        table->free_list = process->next;
+        slot = process->slot;
+    } else {
+        if (table->chunk == NULL || table->chunk_used == PROCESS_CHUNK_SIZE) {
+            table->chunk = (Process*)arena_alloc(&table->arena, sizeof(Process) * PROCESS_CHUNK_SIZE);
+            table->chunk_used = 0;
+            if (table->chunk == NULL) {
+                return NULL;
+            }
+        }
+        if (table->allocated == table->all_capacity) {
+            table->all_capacity = table->all_capacity ? table->all_capacity * 2 : PROCESS_CHUNK_SIZE;
+            table->all = (Process**)realloc(table->all, sizeof(Process*) * table->all_capacity);
+        }
+        process = &table->chunk[table->chunk_used++];
+        slot = table->allocated;
+        table->all[table->allocated++] = process;
+    }
+    memset(process, 0, sizeof(Process));
+    process->slot = slot;
+    table->live++;
+    return process;
+}
+
+// Returns a completed record to the table
+void release_process(ProcessTable* table, Process* process) {
+    int slot = process->slot;
+    memset(process, 0, sizeof(Process));
+    process->slot = slot;
+    process->next = table->free_list;
+    table->free_list = process;
+    table->live--;
+}
+
+void free_process_table(ProcessTable* table) {
+    free_arena(&table->arena);
+    free(table->all);
+    memset(table, 0, sizeof(ProcessTable));
+}
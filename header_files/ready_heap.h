@@ -0,0 +1,126 @@
+#pragma once
+
+// Indexed binary min-heap. Entries are small integer ids ordered by
+// (key, tie), and every id remembers its heap position, so an entry can be
+// re-keyed or removed in O(log n) without searching for it.
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    int *heap;        // Heap of ids
+    int size;
+    int capacity;
+
+    int *pos;         // id -> position in heap, -1 if absent
+    uint64_t *keys;   // id -> primary key
+    uint64_t *ties;   // id -> secondary key, breaks equal primary keys
+    int id_capacity;
+} ReadyHeap;
+
+// Grows the per-id arrays so that id is addressable
+void ready_heap_reserve(ReadyHeap* rh, int id) {
+    if (id < rh->id_capacity) {
+        return;
+    }
+    int new_capacity = rh->id_capacity ? rh->id_capacity : 64;
+    while (new_capacity <= id) {
+        new_capacity *= 2;
+    }
+    rh->pos = (int*)realloc(rh->pos, sizeof(int) * new_capacity);
+    rh->keys = (uint64_t*)realloc(rh->keys, sizeof(uint64_t) * new_capacity);
+    rh->ties = (uint64_t*)realloc(rh->ties, sizeof(uint64_t) * new_capacity);
+    memset(rh->pos + rh->id_capacity, -1, sizeof(int) * (new_capacity - rh->id_capacity));
+    rh->id_capacity = new_capacity;
+}
+
+bool ready_heap_contains(ReadyHeap* rh, int id) {
+    return id < rh->id_capacity && rh->pos[id] != -1;
+}
+
+// True if id a must be picked before id b
+static bool ready_heap_less(ReadyHeap* rh, int a, int b) {
+    if (rh->keys[a] != rh->keys[b]) {
+        return rh->keys[a] < rh->keys[b];
+    }
+    return rh->ties[a] < rh->ties[b];
+}
+
+static void ready_heap_place(ReadyHeap* rh, int index, int id) {
+    rh->heap[index] = id;
+    rh->pos[id] = index;
+}
+
+static void ready_heap_sift_up(ReadyHeap* rh, int index) {
+    int id = rh->heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!ready_heap_less(rh, id, rh->heap[parent])) break;
+        ready_heap_place(rh, index, rh->heap[parent]);
+        index = parent;
+    }
+    ready_heap_place(rh, index, id);
+}
+
+static void ready_heap_sift_down(ReadyHeap* rh, int index) {
+    int id = rh->heap[index];
+    while (1) {
+        int child = 2 * index + 1;
+        if (child >= rh->size) break;
+        if (child + 1 < rh->size && ready_heap_less(rh, rh->heap[child + 1], rh->heap[child])) {
+            child++;
+        }
+        if (!ready_heap_less(rh, rh->heap[child], id)) break;
+        ready_heap_place(rh, index, rh->heap[child]);
+        index = child;
+    }
+    ready_heap_place(rh, index, id);
+}
+
+// Inserts id, or moves it if it is already present
+void ready_heap_update(ReadyHeap* rh, int id, uint64_t key, uint64_t tie) {
+    ready_heap_reserve(rh, id);
+    rh->keys[id] = key;
+    rh->ties[id] = tie;
+
+    if (rh->pos[id] == -1) {
+        if (rh->size == rh->capacity) {
+            rh->capacity = rh->capacity ? rh->capacity * 2 : 64;
+            rh->heap = (int*)realloc(rh->heap, sizeof(int) * rh->capacity);
+        }
+        ready_heap_place(rh, rh->size++, id);
+    }
+    ready_heap_sift_up(rh, rh->pos[id]);
+    ready_heap_sift_down(rh, rh->pos[id]);
+}
+
+// Removes id if present
+void ready_heap_remove(ReadyHeap* rh, int id) {
+    if (!ready_heap_contains(rh, id)) {
+        return;
+    }
+    int index = rh->pos[id];
+    rh->pos[id] = -1;
+    rh->size--;
+    if (index == rh->size) {
+        return;
+    }
+    int moved = rh->heap[rh->size];
+    ready_heap_place(rh, index, moved);
+    ready_heap_sift_up(rh, index);
+    ready_heap_sift_down(rh, rh->pos[moved]);
+}
+
+// Returns the smallest id, or -1 if the heap is empty
+int ready_heap_top(ReadyHeap* rh) {
+    return (rh->size > 0) ? rh->heap[0] : -1;
+}
+
+void free_ready_heap(ReadyHeap* rh) {
+    free(rh->heap);
+    free(rh->pos);
+    free(rh->keys);
+    free(rh->ties);
+    memset(rh, 0, sizeof(ReadyHeap));
+}
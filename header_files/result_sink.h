@@ -0,0 +1,259 @@
+#pragma once
+
+// Buffered output for scheduler results. Records are formatted into an
+// in-memory buffer and written with one write() once the buffer fills up,
+// the flush interval passes, or the sink is closed. In async mode a
+// background thread does the writes, so a slow disk never delays dispatch.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "process.h"
+#include "clock.h"
+
+#define RESULT_SINK_BUFFER_SIZE (64 * 1024)
+#define RESULT_SINK_FLUSH_INTERVAL_MS 1000
+
+// Times are in ms with microsecond decimals, except the launch latency
+#define RESULT_CSV_HEADER "Command,Finished,Error,Burst Time,Turnaround Time,Waiting Time,Response Time,Launch Latency (us),CPU Time"
+// The proportional-share schedulers add the share of its turnaround time a
+// job held the CPU, and the share its tickets entitled it to, in percent
+#define RESULT_SHARE_CSV_HEADER RESULT_CSV_HEADER ",Tickets,CPU Share,Entitled Share"
+// EDF adds the deadline relative to arrival, the lateness (negative when the
+// job finished early) and whether the deadline was met, Rejected if the job
+// was refused at admission
+#define RESULT_DEADLINE_CSV_HEADER RESULT_CSV_HEADER ",Deadline,Lateness,Deadline Met"
+
+typedef struct {
+    int fd;
+    bool owns_fd;  // False for stdout, which must not be closed
+
+    char *buffer;  // Records being appended by the scheduler
+    size_t used;
+    size_t capacity;
+    uint64_t last_flush_ns;
+
+    // Async mode only: the writer thread drains the back buffer
+    bool async;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    char *back;
+    size_t back_used;
+    size_t back_capacity;
+    bool stop;
+} ResultSink;
+
+// Writes the whole range, retrying on short writes
+void result_sink_write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            perror("Error writing results");
+            return;
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+void* result_sink_writer(void* arg) {
+    ResultSink* sink = (ResultSink*)arg;
+    pthread_mutex_lock(&sink->lock);
+    while (!sink->stop || sink->back_used > 0) {
+        if (sink->back_used == 0) {
+            pthread_cond_wait(&sink->cond, &sink->lock);
+            continue;
+        }
+        // Write outside the lock so the scheduler can keep appending
+        char* data = sink->back;
+        size_t size = sink->back_used;
+        pthread_mutex_unlock(&sink->lock);
+        result_sink_write_all(sink->fd, data, size);
+        pthread_mutex_lock(&sink->lock);
+        sink->back_used = 0;
+        pthread_cond_broadcast(&sink->cond);
+    }
+    pthread_mutex_unlock(&sink->lock);
+    return NULL;
+}
+
+// Pushes the buffered records out. In async mode they are handed to the
+// writer thread; if it is still busy with the previous batch the records
+// stay buffered and the buffer grows instead of blocking.
+void flush_result_sink(ResultSink* sink) {
+    sink->last_flush_ns = clock_ns();
+    if (sink->used == 0) {
+        return;
+    }
+    if (!sink->async) {
+        result_sink_write_all(sink->fd, sink->buffer, sink->used);
+        sink->used = 0;
+        return;
+    }
+
+    pthread_mutex_lock(&sink->lock);
+    if (sink->back_used == 0) {
+        char* tmp = sink->back;
+        size_t tmp_capacity = sink->back_capacity;
+        sink->back = sink->buffer;
+        sink->back_capacity = sink->capacity;
+        sink->back_used = sink->used;
+        sink->buffer = tmp;
+        sink->capacity = tmp_capacity;
+        sink->used = 0;
+        pthread_cond_signal(&sink->cond);
+    }
+    pthread_mutex_unlock(&sink->lock);
+}
+
+// Appends one formatted record
+void result_sink_printf(ResultSink* sink, const char* format, ...) {
+    while (1) {
+        va_list args;
+        va_start(args, format);
+        size_t room = sink->capacity - sink->used;
+        int len = vsnprintf(sink->buffer + sink->used, room, format, args);
+        va_end(args);
+        if (len < 0) {
+            return;
+        }
+        if ((size_t)len < room) {
+            sink->used += len;
+            break;
+        }
+        // Record did not fit, make room and format it again
+        size_t used_before = sink->used;
+        flush_result_sink(sink);
+        if (sink->used == used_before) {
+            sink->capacity = sink->capacity * 2 + len;
+            sink->buffer = (char*)realloc(sink->buffer, sink->capacity);
+        }
+    }
+
+    if (sink->used >= RESULT_SINK_BUFFER_SIZE / 2 ||
+        clock_ns() - sink->last_flush_ns >= RESULT_SINK_FLUSH_INTERVAL_MS * NS_PER_MS) {
+        flush_result_sink(sink);
+    }
+}
+
+// Opens a sink on fd. Async mode is used when SCHEDULER_ASYNC_WRITER=1.
+int open_result_sink_fd(ResultSink* sink, int fd, bool owns_fd) {
+    memset(sink, 0, sizeof(ResultSink));
+    sink->fd = fd;
+    sink->owns_fd = owns_fd;
+    sink->capacity = RESULT_SINK_BUFFER_SIZE;
+    sink->buffer = (char*)malloc(sink->capacity);
+    sink->last_flush_ns = clock_ns();
+    if (fd == STDOUT_FILENO) {
+        fflush(stdout);  // Keep earlier printf output ahead of our records
+    }
+
+    const char* async = getenv("SCHEDULER_ASYNC_WRITER");
+    if (async != NULL && strcmp(async, "1") == 0) {
+        sink->back_capacity = RESULT_SINK_BUFFER_SIZE;
+        sink->back = (char*)malloc(sink->back_capacity);
+        pthread_mutex_init(&sink->lock, NULL);
+        pthread_cond_init(&sink->cond, NULL);
+        sink->async = pthread_create(&sink->writer, NULL, result_sink_writer, sink) == 0;
+        if (!sink->async) {
+            free(sink->back);
+            sink->back = NULL;
+        }
+    }
+    return 0;
+}
+
+// Creates (truncates) filename and writes the header line if given
+int open_result_sink(ResultSink* sink, const char* filename, const char* header) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("Error opening CSV file");
+        return -1;
+    }
+    open_result_sink_fd(sink, fd, true);
+    if (header != NULL) {
+        result_sink_printf(sink, "%s\n", header);
+    }
+    return 0;
+}
+
+// Flushes everything, stops the writer thread and closes the file
+void close_result_sink(ResultSink* sink) {
+    if (sink->buffer == NULL) {
+        return;
+    }
+    if (sink->async) {
+        // Hand over the remainder once the writer is free
+        pthread_mutex_lock(&sink->lock);
+        while (sink->back_used > 0) {
+            pthread_cond_wait(&sink->cond, &sink->lock);
+        }
+        pthread_mutex_unlock(&sink->lock);
+        flush_result_sink(sink);
+
+        pthread_mutex_lock(&sink->lock);
+        sink->stop = true;
+        pthread_cond_signal(&sink->cond);
+        pthread_mutex_unlock(&sink->lock);
+        pthread_join(sink->writer, NULL);
+        pthread_mutex_destroy(&sink->lock);
+        pthread_cond_destroy(&sink->cond);
+        free(sink->back);
+    } else {
+        flush_result_sink(sink);
+    }
+    if (sink->owns_fd) {
+        close(sink->fd);
+    }
+    free(sink->buffer);
+    sink->buffer = NULL;
+}
+
+// Splits a ns duration into whole ms and the microsecond remainder
+#define CSV_MS(ns) (ns) / NS_PER_MS, (ns) % NS_PER_MS / NS_PER_US
+
+// The RESULT_CSV_HEADER columns of a job
+#define RESULT_CSV_ROW "%s,%s,%s,%lu.%03lu,%lu.%03lu,%lu.%03lu,%lu.%03lu,%lu,%lu.%03lu"
+#define RESULT_CSV_FIELDS(p) \
+    (p).command, (p).finished ? "Yes" : "No", (p).error ? "Yes" : "No", \
+    CSV_MS((p).burst_time), CSV_MS((p).turnaround_time), CSV_MS((p).waiting_time), \
+    CSV_MS((p).response_time), (p).launch_latency / NS_PER_US, CSV_MS((p).cpu_time)
+
+// Writes the output to csv file
+void write_to_csv(ResultSink* sink, Process p) {
+    result_sink_printf(sink, RESULT_CSV_ROW "\n", RESULT_CSV_FIELDS(p));
+}
+
+// Writes a row with the proportional-share columns. entitled_time is the
+// CPU time the job's tickets entitled it to over its turnaround time.
+void write_share_to_csv(ResultSink* sink, Process p, int tickets, uint64_t entitled_time) {
+    double turnaround = p.turnaround_time > 0 ? (double)p.turnaround_time : 1;
+    result_sink_printf(sink, RESULT_CSV_ROW ",%d,%.1f,%.1f\n", RESULT_CSV_FIELDS(p),
+            tickets, 100 * p.burst_time / turnaround, 100 * entitled_time / turnaround);
+}
+
+// Writes a row with the EDF columns, left empty for jobs without a deadline
+void write_deadline_to_csv(ResultSink* sink, Process p, bool rejected) {
+    if (p.deadline == 0) {
+        result_sink_printf(sink, RESULT_CSV_ROW ",,,\n", RESULT_CSV_FIELDS(p));
+        return;
+    }
+    uint64_t relative = p.deadline - p.arrival_time;
+    if (rejected) {
+        result_sink_printf(sink, RESULT_CSV_ROW ",%lu.%03lu,,Rejected\n", RESULT_CSV_FIELDS(p), CSV_MS(relative));
+        return;
+    }
+    bool met = p.completion_time <= p.deadline;
+    uint64_t lateness = met ? p.deadline - p.completion_time : p.completion_time - p.deadline;
+    result_sink_printf(sink, RESULT_CSV_ROW ",%lu.%03lu,%s%lu.%03lu,%s\n", RESULT_CSV_FIELDS(p), CSV_MS(relative),
+            (met && lateness > 0) ? "-" : "", CSV_MS(lateness), met ? "Yes" : "No");
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// Run queue shared by the MLFQ schedulers. Processes are chained through
+// their intrusive next pointer, so enqueue, dequeue and moving a whole queue
+// onto another (used by the priority boost) are all O(1).
+#include <stdlib.h>
+#include "process.h"
+
+// Defines a queue
+typedef struct {
+    Process *head;
+    Process *tail;
+    int size;
+} Queue;
+
+// Creates queue
+Queue* createQueue() {
+    Queue* queue = (Queue*)malloc(sizeof(Queue));
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->size = 0;
+    return queue;
+}
+
+// Enques the process to queue
+void enqueue(Queue* queue, Process* process) {
+    process->next = NULL;
+    if (queue->tail != NULL) {
+        queue->tail->next = process;
+    } else {
+        queue->head = process;
+    }
+    queue->tail = process;
+    queue->size++;
+}
+
+// Performs dqeueue
+Process* dequeue(Queue* queue) {
+    Process* process = queue->head;
+    if (process != NULL) {
+        queue->head = process->next;
+        if (queue->head == NULL) {
+            queue->tail = NULL;
+        }
+        process->next = NULL;
+        queue->size--;
+    }
+    return process;
+}
+
+// Appends every process of src to the end of dst and empties src
+void splice_queue(Queue* dst, Queue* src) {
+    if (src->head == NULL) {
+        return;
+    }
+    if (dst->tail != NULL) {
+        dst->tail->next = src->head;
+    } else {
+        dst->head = src->head;
+    }
+    dst->tail = src->tail;
+    dst->size += src->size;
+
+    src->head = NULL;
+    src->tail = NULL;
+    src->size = 0;
+}
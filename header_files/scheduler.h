@@ -0,0 +1,101 @@
+#pragma once
+
+// Entry point of the dispatch core: runs any policy, offline, online or
+// simulated.
+// Each policy's loop is compiled from scheduler_loop.h with its own hooks,
+// and run_scheduler() only chooses between them once per run.
+#include "scheduler_policies.h"
+
+#define SCHEDULER_CONCAT(a, b) SCHEDULER_CONCAT_(a, b)
+#define SCHEDULER_CONCAT_(a, b) a##_##b
+
+#define SCHEDULER_POLICY fcfs
+#define SCHEDULER_STATE FcfsState
+#define SCHEDULER_PREEMPTIVE FCFS_PREEMPTIVE
+#include "scheduler_loop.h"
+
+#define SCHEDULER_POLICY rr
+#define SCHEDULER_STATE RrState
+#define SCHEDULER_PREEMPTIVE RR_PREEMPTIVE
+#include "scheduler_loop.h"
+
+#define SCHEDULER_POLICY mlfq
+#define SCHEDULER_STATE MlfqState
+#define SCHEDULER_PREEMPTIVE MLFQ_PREEMPTIVE
+#include "scheduler_loop.h"
+
+#define SCHEDULER_POLICY sjf
+#define SCHEDULER_STATE NoPolicyState
+#define SCHEDULER_PREEMPTIVE SJF_PREEMPTIVE
+#include "scheduler_loop.h"
+
+#define SCHEDULER_POLICY srtf
+#define SCHEDULER_STATE NoPolicyState
+#define SCHEDULER_PREEMPTIVE SRTF_PREEMPTIVE
+#include "scheduler_loop.h"
+
+#define SCHEDULER_POLICY cfs
+#define SCHEDULER_STATE CfsState
+#define SCHEDULER_PREEMPTIVE CFS_PREEMPTIVE
+#include "scheduler_loop.h"
+
+#define SCHEDULER_POLICY share
+#define SCHEDULER_STATE ShareState
+#define SCHEDULER_PREEMPTIVE SHARE_PREEMPTIVE
+#include "scheduler_loop.h"
+
+#define SCHEDULER_POLICY edf
+#define SCHEDULER_STATE EdfState
+#define SCHEDULER_PREEMPTIVE EDF_PREEMPTIVE
+#include "scheduler_loop.h"
+
+// Runs policy over the jobs of source, see run_scheduler(). Stores the
+// event count and end time of a simulation in *stats if set.
+static int dispatch_scheduler(SchedulerPolicy policy, SchedulerMode mode, const SchedulerParams* params,
+                              const SchedulerSource* source, SimStats* stats) {
+    const char* headers[] = {FCFS_CSV_HEADER, RR_CSV_HEADER, MLFQ_CSV_HEADER, SJF_CSV_HEADER, SRTF_CSV_HEADER,
+                             CFS_CSV_HEADER, SHARE_CSV_HEADER, SHARE_CSV_HEADER, EDF_CSV_HEADER};
+    bool preemptive[] = {FCFS_PREEMPTIVE, RR_PREEMPTIVE, MLFQ_PREEMPTIVE, SJF_PREEMPTIVE, SRTF_PREEMPTIVE,
+                         CFS_PREEMPTIVE, SHARE_PREEMPTIVE, SHARE_PREEMPTIVE, EDF_PREEMPTIVE};
+    SchedulerCore core;
+    if (open_scheduler_core(&core, mode, policy, headers[policy], preemptive[policy], source) < 0) {
+        return -1;
+    }
+    switch (policy) {
+        case POLICY_FCFS: fcfs_dispatch(&core, policy, params); break;
+        case POLICY_RR: rr_dispatch(&core, policy, params); break;
+        case POLICY_MLFQ: mlfq_dispatch(&core, policy, params); break;
+        case POLICY_SJF: sjf_dispatch(&core, policy, params); break;
+        case POLICY_SRTF: srtf_dispatch(&core, policy, params); break;
+        case POLICY_CFS: cfs_dispatch(&core, policy, params); break;
+        case POLICY_STRIDE:
+        case POLICY_LOTTERY: share_dispatch(&core, policy, params); break;
+        case POLICY_EDF: edf_dispatch(&core, policy, params); break;
+    }
+    if (stats != NULL) {
+        *stats = core.stats;
+        stats->end_time = core.current_time;
+    }
+    close_scheduler_core(&core);
+    return 0;
+}
+
+// Runs policy and writes result_<mode>_<policy>.csv. Offline, jobs[] are
+// the n jobs to run, arriving at their arrival_time (ns on the scheduler
+// clock, which starts at 0), and their results are filled in; online, jobs
+// are read from stdin and the submission socket until quit. Returns -1 if
+// the output could not be opened.
+int run_scheduler(SchedulerPolicy policy, SchedulerMode mode, const SchedulerParams* params, Process jobs[], int n) {
+    SchedulerSource source = {.jobs = jobs, .n = n};
+    return dispatch_scheduler(policy, mode, params, &source, NULL);
+}
+
+// Runs policy offline over the jobs of an open workload file, taking each
+// as its arrival time comes due, and writes result_offline_<policy>.csv.
+// Memory is bounded by the jobs that have arrived and not yet completed,
+// plus the history kept for each distinct command.
+// Returns -1 if the output could not be opened.
+int run_scheduler_workload(SchedulerPolicy policy, const SchedulerParams* params, WorkloadFile* workload) {
+    SchedulerSource source = {.workload = workload};
+    return dispatch_scheduler(policy, SCHEDULER_OFFLINE, params, &source, NULL);
+}
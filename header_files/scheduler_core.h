@@ -0,0 +1,449 @@
+#pragma once
+
+// Dispatch core shared by every single-CPU policy, offline and online. The
+// core owns what all of them do the same way: taking arrivals, starting a
+// job, running it for a slice, the job's times, the burst history, the
+// context-switch log and the CSV file. A policy only decides which job runs
+// next and for how long, through the hooks in scheduler_policies.h, and the
+// loop in scheduler_loop.h is compiled once per policy with its hooks
+// inlined, so no indirect call sits on the dispatch path.
+//
+// Offline, jobs come from an array or a workload file (see workload.h) and
+// arrive as the scheduler clock reaches their arrival time. Online, they come from stdin and the submission socket
+// and arrive at the current time. Simulated, they declare their CPU demand
+// up front and a slice only advances a virtual clock, so no process is ever
+// started (see simulator.h). Either way they are copied into the online
+// process table, so every policy sees the same job records.
+#include "online_state.h"
+#include "workload.h"
+
+typedef enum {
+    SCHEDULER_OFFLINE,
+    SCHEDULER_ONLINE,
+    SCHEDULER_SIMULATED
+} SchedulerMode;
+
+typedef enum {
+    POLICY_FCFS,
+    POLICY_RR,
+    POLICY_MLFQ,
+    POLICY_SJF,
+    POLICY_SRTF,
+    POLICY_CFS,
+    POLICY_STRIDE,
+    POLICY_LOTTERY,
+    POLICY_EDF
+} SchedulerPolicy;
+
+#define SCHEDULER_POLICY_COUNT (POLICY_EDF + 1)
+
+const char* scheduler_policy_names[] = {"FCFS", "RR", "MLFQ", "SJF", "SRTF", "CFS", "Stride", "Lottery", "EDF"};
+const char* scheduler_mode_names[] = {"offline", "online", "sim"};
+
+// Returns the policy called name, or -1
+int find_scheduler_policy(const char* name) {
+    for (int i = 0; i < SCHEDULER_POLICY_COUNT; i++) {
+        if (strcmp(name, scheduler_policy_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Policy parameters in ms, each policy reads the ones it needs
+typedef struct {
+    int quantum;                       // RR, stride and lottery
+    int quantum0, quantum1, quantum2;  // MLFQ
+    int boost_time;                    // MLFQ
+} SchedulerParams;
+
+// Job of a simulation, times in ns
+typedef struct {
+    char *command;
+    uint64_t arrival_time;
+    uint64_t burst_time;  // CPU time the job needs
+} SimJob;
+
+typedef struct {
+    uint64_t events;    // Arrivals plus slice ends
+    uint64_t end_time;  // Virtual time at which the last job completed
+} SimStats;
+
+// Where the jobs of a run come from: offline the n jobs[] or workload,
+// simulated the n sim_jobs[], online none of them
+typedef struct {
+    Process *jobs;
+    SimJob *sim_jobs;
+    int n;
+    WorkloadFile *workload;
+} SchedulerSource;
+
+typedef struct {
+    SchedulerMode mode;
+    ResultSink csv;
+    ContextSwitchLog context_switches;
+    SliceEngine engine;
+    uint64_t current_time;
+    Process *running;  // Job whose slice is paused for an arrival, NULL otherwise
+    Queue arrived;  // Jobs taken by scheduler_poll_arrivals, not yet given to the policy
+
+    // Offline and simulated: jobs[order[next]] or sim_jobs[order[next]] is
+    // the next job to arrive
+    Process *jobs;
+    SimJob *sim_jobs;
+    int *order;
+    int n;
+    int next;
+    Process **origins;  // Slot -> offline record the results are copied back to
+    int origins_capacity;
+    WorkloadFile *workload;  // Replaces jobs when set, results only go to the CSV file
+
+    // Simulated
+    uint64_t *remaining;  // Slot -> CPU demand left
+    uint64_t slice_deadline;  // Virtual time the running job's quantum ends, UINT64_MAX for none
+    int remaining_capacity;
+    SimStats stats;
+
+    // Online
+    char command[MAX_COMMAND_LENGTH];
+    int quit;
+} SchedulerCore;
+
+// Signal handlers replaced by the scheduler's own while it runs
+struct sigaction scheduler_saved_sigint, scheduler_saved_sigterm;
+
+// SIGINT and SIGTERM only set a flag, which ends the running slice and then
+// the dispatch loop, so close_scheduler_core() still kills the jobs and
+// writes out every buffered result
+void scheduler_stop_handler(int signal_number) {
+    (void)signal_number;
+    slice_stop_requested = 1;
+}
+
+// Arrival time of jobs[index] or sim_jobs[index]
+static inline uint64_t scheduler_job_arrival(SchedulerCore* core, int index) {
+    return core->sim_jobs != NULL ? core->sim_jobs[index].arrival_time : core->jobs[index].arrival_time;
+}
+
+// Core whose jobs are being sorted by compare_offline_arrivals
+SchedulerCore *scheduler_sort_core = NULL;
+
+// Orders job indices by arrival time, then by position in the input
+int compare_offline_arrivals(const void* a, const void* b) {
+    int i = *(const int*)a, j = *(const int*)b;
+    uint64_t arrival_i = scheduler_job_arrival(scheduler_sort_core, i);
+    uint64_t arrival_j = scheduler_job_arrival(scheduler_sort_core, j);
+    if (arrival_i != arrival_j) {
+        return arrival_i < arrival_j ? -1 : 1;
+    }
+    return i - j;
+}
+
+// Opens result_<mode>_<policy>.csv and the context-switch log, and sets up
+// the slice engine, which a simulation does not need. Slices of preemptive
+// policies also end when input arrives. The jobs to run come from source.
+int open_scheduler_core(SchedulerCore* core, SchedulerMode mode, SchedulerPolicy policy, const char* header,
+                        bool preemptive, const SchedulerSource* source) {
+    memset(core, 0, sizeof(SchedulerCore));
+    core->mode = mode;
+    core->engine.epoll_fd = core->engine.timer_fd = -1;
+    char filename[64];
+    snprintf(filename, sizeof(filename), "result_%s_%s.csv", scheduler_mode_names[mode], scheduler_policy_names[policy]);
+    if (open_result_sink(&core->csv, filename, header) < 0) {
+        return -1;
+    }
+    open_context_switch_log(&core->context_switches);
+    if (mode == SCHEDULER_SIMULATED) {
+        core->context_switches.trace.virtual_time = true;  // Overhead is the real time spent per event
+    }
+
+    // No SA_RESTART, so a blocking select() or epoll_wait() returns at once
+    struct sigaction stop = {.sa_handler = scheduler_stop_handler};
+    sigemptyset(&stop.sa_mask);
+    slice_stop_requested = 0;
+    sigaction(SIGINT, &stop, &scheduler_saved_sigint);
+    sigaction(SIGTERM, &stop, &scheduler_saved_sigterm);
+
+    if ((mode != SCHEDULER_SIMULATED && slice_engine_init(&core->engine) < 0) ||
+        (mode == SCHEDULER_ONLINE && preemptive &&
+         (slice_engine_watch_input(&core->engine, STDIN_FILENO) < 0 ||
+          (submit_server != NULL && slice_engine_watch_input(&core->engine, submit_server->wake_fd) < 0)))) {
+        close_result_sink(&core->csv);
+        close_context_switch_log(&core->context_switches);
+        return -1;
+    }
+
+    if (mode == SCHEDULER_OFFLINE && source->workload != NULL) {
+        core->workload = source->workload;
+    } else if (mode != SCHEDULER_ONLINE) {
+        core->jobs = (mode == SCHEDULER_OFFLINE) ? source->jobs : NULL;
+        core->sim_jobs = (mode == SCHEDULER_SIMULATED) ? source->sim_jobs : NULL;
+        core->n = source->n;
+        core->order = (int*)malloc(sizeof(int) * (core->n > 0 ? core->n : 1));
+        for (int i = 0; i < core->n; i++) {
+            core->order[i] = i;
+        }
+        scheduler_sort_core = core;
+        qsort(core->order, core->n, sizeof(int), compare_offline_arrivals);
+    }
+    return 0;
+}
+
+// Kills the jobs still running, then closes everything and frees the
+// online state
+void close_scheduler_core(SchedulerCore* core) {
+    for (int i = 0; i < process_table.allocated; i++) {
+        Process* process = process_table.all[i];
+        if (process->pid > 0) {
+            job_kill(process->pid);  // The whole tree, not just the shell
+            waitpid(process->pid, NULL, 0);
+            job_release(process->pid);
+        }
+    }
+    slice_engine_destroy(&core->engine);
+    close_result_sink(&core->csv);
+    close_context_switch_log(&core->context_switches);
+    sigaction(SIGINT, &scheduler_saved_sigint, NULL);
+    sigaction(SIGTERM, &scheduler_saved_sigterm, NULL);
+    free(core->order);
+    free(core->origins);
+    free(core->remaining);
+    free_online_state();
+}
+
+// Copies an offline record into the process table. Its deadline, like a
+// [deadline=] option, is relative to its arrival.
+Process* admit_offline_job(SchedulerCore* core, Process* job) {
+    Process* process = add_process(job->command, job->arrival_time);
+    if (process == NULL) {
+        return NULL;
+    }
+    if (job->weight) process->weight = job->weight;
+    if (job->tickets) process->tickets = job->tickets;
+    if (job->deadline) process->deadline = job->arrival_time + job->deadline;
+    if (process->slot >= core->origins_capacity) {
+        core->origins_capacity = core->origins_capacity ? core->origins_capacity * 2 : PROCESS_CHUNK_SIZE;
+        core->origins = (Process**)realloc(core->origins, sizeof(Process*) * core->origins_capacity);
+    }
+    core->origins[process->slot] = job;
+    return process;
+}
+
+// Adds a simulated job to the process table, with its CPU demand
+Process* admit_sim_job(SchedulerCore* core, SimJob* job) {
+    Process* process = add_process(job->command, job->arrival_time);
+    if (process == NULL) {
+        return NULL;
+    }
+    if (process->slot >= core->remaining_capacity) {
+        core->remaining_capacity = core->remaining_capacity ? core->remaining_capacity * 2 : PROCESS_CHUNK_SIZE;
+        core->remaining = (uint64_t*)realloc(core->remaining, sizeof(uint64_t) * core->remaining_capacity);
+    }
+    core->remaining[process->slot] = job->burst_time;
+    return process;
+}
+
+// Moves every job that has arrived by now to core->arrived. Sets quit once
+// the scheduler was asked to stop by a signal.
+void scheduler_poll_arrivals(SchedulerCore* core) {
+    if (slice_stop_requested) {
+        core->quit = 1;
+        return;
+    }
+    if (core->workload != NULL) {
+        WorkloadFile* workload = core->workload;
+        while (workload->pending && workload->arrival_time <= core->current_time) {
+            Process* arrived = add_process(workload->command, workload->arrival_time);
+            if (arrived != NULL) {
+                enqueue(&core->arrived, arrived);
+            }
+            workload_advance(workload);
+        }
+        return;
+    }
+    if (core->mode != SCHEDULER_ONLINE) {
+        while (core->next < core->n && scheduler_job_arrival(core, core->order[core->next]) <= core->current_time) {
+            int index = core->order[core->next++];
+            Process* arrived = core->sim_jobs != NULL ? admit_sim_job(core, &core->sim_jobs[index])
+                                                      : admit_offline_job(core, &core->jobs[index]);
+            if (arrived != NULL) {
+                enqueue(&core->arrived, arrived);
+                core->stats.events++;
+            }
+        }
+        return;
+    }
+    Process* arrived;
+    while ((arrived = check_and_add_input(core->command, &core->quit, core->current_time)) != NULL) {
+        enqueue(&core->arrived, arrived);
+    }
+    take_submissions(&core->arrived, &core->quit, core->current_time);
+    if (!stdin_open) {
+        slice_engine_unwatch_input(&core->engine, STDIN_FILENO);  // Would stay readable at end of file
+    }
+}
+
+// Stores the arrival time of the next offline job in *arrival. Returns
+// false if every job has arrived.
+bool scheduler_next_arrival(SchedulerCore* core, uint64_t* arrival) {
+    if (core->workload != NULL) {
+        *arrival = core->workload->arrival_time;
+        return core->workload->pending;
+    }
+    if (core->next == core->n) {
+        return false;
+    }
+    *arrival = scheduler_job_arrival(core, core->order[core->next]);
+    return true;
+}
+
+// Waits for the next arrival when no job is ready. Offline and simulated the clock skips
+// ahead to it. Online the results so far are written out first, since the
+// wait has no end. Returns false once no job will ever arrive again.
+bool scheduler_wait(SchedulerCore* core) {
+    if (core->mode == SCHEDULER_ONLINE) {
+        flush_result_sink(&core->csv);
+        flush_context_switch_log(&core->context_switches);
+        wait_for_input();
+        return true;
+    }
+    uint64_t arrival;
+    if (!scheduler_next_arrival(core, &arrival)) {
+        return false;
+    }
+    if (arrival > core->current_time) {
+        core->current_time = arrival;
+    }
+    return true;
+}
+
+// Time (ns) until the next offline or simulated job arrives, when a slice
+// of a preemptive policy pauses for it. Online, input pauses the slice
+// instead.
+uint64_t scheduler_until_arrival(SchedulerCore* core) {
+    uint64_t arrival;
+    if (core->mode == SCHEDULER_ONLINE || !scheduler_next_arrival(core, &arrival)) {
+        return SLICE_NO_WAKE;
+    }
+    return arrival > core->current_time ? arrival - core->current_time : 0;
+}
+
+// Runs a simulated job until the quantum ends, its demand is met or the
+// wake time comes, like begin_slice() and continue_slice(). A simulated
+// job never blocks, so it uses the CPU for the whole time.
+SliceResult scheduler_simulate_slice(SchedulerCore* core, Process* process, uint64_t wake) {
+    SliceResult slice = {.outcome = SLICE_EXPIRED, .status = 0};
+    uint64_t* remaining = &core->remaining[process->slot];
+    uint64_t quantum_left = core->slice_deadline - core->current_time;
+    slice.elapsed_ns = *remaining < quantum_left ? *remaining : quantum_left;
+    if (wake < slice.elapsed_ns) {
+        slice.elapsed_ns = wake;
+        slice.outcome = SLICE_INTERRUPTED;
+    }
+    *remaining -= slice.elapsed_ns;
+    slice.cpu_ns = process->cpu_time + slice.elapsed_ns;
+    if (*remaining == 0) {
+        slice.outcome = SLICE_EXITED;
+    }
+    core->stats.events++;
+    return slice;
+}
+
+// Accounts for the part of a slice since it began or was last paused, and
+// adds it to *slice. Clears core->running once the slice is over.
+void scheduler_account_slice(SchedulerCore* core, Process* process, SliceResult* slice, SliceResult part) {
+    process->burst_time += part.elapsed_ns;
+    process->cpu_time = part.cpu_ns;
+    core->current_time += part.elapsed_ns;
+    slice->outcome = part.outcome;
+    slice->status = part.status;
+    slice->elapsed_ns += part.elapsed_ns;
+    slice->cpu_ns = part.cpu_ns;
+    if (part.outcome == SLICE_EXITED) {
+        if (WIFEXITED(part.status) && WEXITSTATUS(part.status) == 0) {
+            process->finished = true;
+        } else {
+            process->error = true;
+        }
+    }
+}
+
+// Starts the job if it never ran, then runs it for up to quantum ms and
+// accounts for the slice. A slice paused by an arrival, see begin_slice(),
+// comes back SLICE_INTERRUPTED with the job still in core->running, to be
+// ended by scheduler_continue_slice() or scheduler_stop_slice().
+SliceResult scheduler_run_slice(SchedulerCore* core, Process* process, uint64_t quantum, uint64_t wake) {
+    if (!process->started) {
+        process->start_time = core->current_time;
+        process->response_time = core->current_time - process->arrival_time;
+        process->started = true;
+
+        // A failed launch shows up as an exit
+        if (core->mode != SCHEDULER_SIMULATED) {
+            process->pid = launch_command(process->command, &process->launch_latency);
+        }
+    }
+
+    SliceResult slice = {.outcome = SLICE_EXPIRED, .status = 0};
+    SliceResult part;
+    if (core->mode == SCHEDULER_SIMULATED) {
+        core->slice_deadline = (quantum == SLICE_UNLIMITED) ? UINT64_MAX
+                             : core->current_time + (quantum > 0 ? quantum : 1) * NS_PER_MS;  // Like run_slice, a zero quantum still runs 1ms
+        part = scheduler_simulate_slice(core, process, wake);
+    } else {
+        part = begin_slice(&core->engine, process->pid, quantum, wake);
+    }
+    scheduler_account_slice(core, process, &slice, part);
+    core->running = (part.outcome == SLICE_INTERRUPTED) ? process : NULL;
+    return slice;
+}
+
+// Goes on with the paused slice of core->running, which keeps the CPU
+void scheduler_continue_slice(SchedulerCore* core, SliceResult* slice, uint64_t wake) {
+    Process* process = core->running;
+    SliceResult part = (core->mode == SCHEDULER_SIMULATED) ? scheduler_simulate_slice(core, process, wake)
+                                                           : continue_slice(&core->engine, wake);
+    scheduler_account_slice(core, process, slice, part);
+    core->running = (part.outcome == SLICE_INTERRUPTED) ? process : NULL;
+}
+
+// Ends the paused slice of core->running, which gives up the CPU
+void scheduler_stop_slice(SchedulerCore* core, SliceResult* slice) {
+    Process* process = core->running;
+    SliceResult part = {.outcome = SLICE_INTERRUPTED, .status = 0, .cpu_ns = process->cpu_time};
+    if (core->mode != SCHEDULER_SIMULATED) {
+        part = stop_slice(&core->engine);
+    }
+    scheduler_account_slice(core, process, slice, part);
+    core->running = NULL;
+}
+
+// Fills in the times of a job that just exited and feeds its burst to the
+// history
+void scheduler_finish_job(SchedulerCore* core, Process* process) {
+    if (process->finished) {
+        update_process_history(process->command_id, observed_burst_time(process));
+    }
+    process->pid = 0;
+    process->completion_time = core->current_time;
+    process->turnaround_time = process->completion_time - process->arrival_time;
+    process->waiting_time = process->turnaround_time - process->burst_time;
+}
+
+// Returns a completed (or rejected) job's record to the table. Offline jobs
+// from an array have their results copied back to the caller's record
+// first, which keeps its own relative deadline for the next run.
+void scheduler_release_job(SchedulerCore* core, Process* process) {
+    if (core->jobs != NULL) {
+        Process* origin = core->origins[process->slot];
+        char* command = origin->command;
+        int process_id = origin->process_id;
+        uint64_t deadline = origin->deadline;
+        *origin = *process;
+        origin->command = command;
+        origin->process_id = process_id;
+        origin->deadline = deadline;
+        origin->next = NULL;
+    }
+    release_process(&process_table, process);
+}
@@ -0,0 +1,66 @@
+// Dispatch loop of one policy. Included by scheduler.h once per policy,
+// with SCHEDULER_POLICY set to the prefix of its hooks, SCHEDULER_STATE to
+// its state type and SCHEDULER_PREEMPTIVE to whether arrivals pause slices
+// (1 or 0), so that the hooks are called directly and can be inlined. Defines
+// <prefix>_dispatch(). No include guard, on purpose.
+
+#define SCHEDULER_HOOK(name) SCHEDULER_CONCAT(SCHEDULER_POLICY, name)
+
+// Runs the policy until every offline job completed, or online until quit
+void SCHEDULER_HOOK(dispatch)(SchedulerCore* core, SchedulerPolicy policy, const SchedulerParams* params) {
+    SCHEDULER_STATE state;
+    SCHEDULER_HOOK(init)(core, &state, policy, params);
+
+    while (1) {
+        scheduler_poll_arrivals(core);
+        Process* process;
+        while ((process = dequeue(&core->arrived)) != NULL) {
+            SCHEDULER_HOOK(on_arrival)(core, &state, process);
+        }
+        if (core->quit) break;
+
+        int level = 0;
+        uint64_t quantum = SLICE_UNLIMITED;
+        process = SCHEDULER_HOOK(pick_next)(core, &state, &level, &quantum);
+        if (process == NULL) {
+            if (!scheduler_wait(core)) break;
+            continue;
+        }
+        uint64_t context_switch_start = core->current_time;
+        SliceResult slice = scheduler_run_slice(core, process, quantum,
+                                                SCHEDULER_PREEMPTIVE ? scheduler_until_arrival(core) : SLICE_NO_WAKE);
+        while (core->running != NULL) {
+#if SCHEDULER_PREEMPTIVE
+            // An arrival paused the slice: the job keeps the CPU, without
+            // being stopped, unless the policy preempts it for a newcomer
+            scheduler_poll_arrivals(core);
+            Process* arrived;
+            while ((arrived = dequeue(&core->arrived)) != NULL) {
+                SCHEDULER_HOOK(on_arrival)(core, &state, arrived);
+            }
+            if (core->quit || SCHEDULER_HOOK(preempts)(core, &state, process)) {
+                scheduler_stop_slice(core, &slice);
+            } else {
+                scheduler_continue_slice(core, &slice, scheduler_until_arrival(core));
+            }
+#else
+            scheduler_stop_slice(core, &slice);  // Only asked to stop
+#endif
+        }
+        SCHEDULER_HOOK(on_slice_end)(core, &state, process, level, &slice);
+        log_context_switch(&core->context_switches, process, 0, level, slice_trace_reason(slice.outcome),
+                           context_switch_start, core->current_time);
+        if (slice.outcome == SLICE_EXITED) {
+            scheduler_finish_job(core, process);
+            SCHEDULER_HOOK(on_complete)(core, &state, process);
+            scheduler_release_job(core, process);
+        }
+    }
+
+    SCHEDULER_HOOK(destroy)(core, &state);
+}
+
+#undef SCHEDULER_HOOK
+#undef SCHEDULER_POLICY
+#undef SCHEDULER_STATE
+#undef SCHEDULER_PREEMPTIVE
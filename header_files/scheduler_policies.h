@@ -0,0 +1,372 @@
+#pragma once
+
+// Scheduling policies of the dispatch core. A policy <name> provides a
+// state type and these hooks, all static inline so that they are inlined
+// into its dispatch loop:
+//
+//   <name>_init(core, state, policy, params)   sets up the ready set
+//   <name>_on_arrival(core, state, process)    a job arrived
+//   <name>_pick_next(core, state, &level, &quantum)
+//                                               removes and returns the next
+//                                               job, or NULL when none is ready,
+//                                               with its queue level and its
+//                                               quantum in ms (SLICE_UNLIMITED
+//                                               to run until exit or input)
+//   <name>_on_slice_end(core, state, process, level, slice)
+//                                               the job's slice ended; it goes
+//                                               back to the ready set unless
+//                                               it exited
+//   <name>_on_complete(core, state, process)   the job exited, write its row
+//   <name>_destroy(core, state)                frees the ready set
+//
+// plus <NAME>_CSV_HEADER and <NAME>_PREEMPTIVE, 1 when arrivals pause the
+// running slice. A preemptive policy also provides
+//
+//   <name>_preempts(core, state, process)      true if a ready job should
+//                                               take the CPU from process,
+//                                               whose slice an arrival paused
+//
+// See scheduler.h for how they are instantiated.
+#include "scheduler_core.h"
+
+// Marks a hook parameter the policy has no use for
+#define HOOK_UNUSED __attribute__((unused))
+
+// State type of the policies whose ready set is the online state's (C wants
+// a struct to have a member)
+typedef struct {
+    char none;
+} NoPolicyState;
+
+// First-Come, First-Served (FCFS)
+
+#define FCFS_CSV_HEADER RESULT_CSV_HEADER
+#define FCFS_PREEMPTIVE 0
+
+typedef struct {
+    Queue ready;
+} FcfsState;
+
+static inline void fcfs_init(SchedulerCore* core HOOK_UNUSED, FcfsState* state, SchedulerPolicy policy HOOK_UNUSED, const SchedulerParams* params HOOK_UNUSED) {
+    state->ready = (Queue){NULL, NULL, 0};
+}
+
+static inline void fcfs_on_arrival(SchedulerCore* core HOOK_UNUSED, FcfsState* state, Process* process) {
+    enqueue(&state->ready, process);
+}
+
+static inline Process* fcfs_pick_next(SchedulerCore* core HOOK_UNUSED, FcfsState* state, int* level HOOK_UNUSED, uint64_t* quantum HOOK_UNUSED) {
+    return dequeue(&state->ready);
+}
+
+static inline void fcfs_on_slice_end(SchedulerCore* core HOOK_UNUSED, FcfsState* state, Process* process, int level HOOK_UNUSED, SliceResult* slice) {
+    if (slice->outcome != SLICE_EXITED) {
+        enqueue(&state->ready, process);  // Only if the slice engine failed
+    }
+}
+
+static inline void fcfs_on_complete(SchedulerCore* core, FcfsState* state HOOK_UNUSED, Process* process) {
+    write_to_csv(&core->csv, *process);
+}
+
+static inline void fcfs_destroy(SchedulerCore* core HOOK_UNUSED, FcfsState* state HOOK_UNUSED) {
+}
+
+// Round Robin (RR)
+
+#define RR_CSV_HEADER RESULT_CSV_HEADER
+#define RR_PREEMPTIVE 0
+
+typedef struct {
+    Queue ready;
+    int quantum;
+} RrState;
+
+static inline void rr_init(SchedulerCore* core HOOK_UNUSED, RrState* state, SchedulerPolicy policy HOOK_UNUSED, const SchedulerParams* params) {
+    state->ready = (Queue){NULL, NULL, 0};
+    state->quantum = params->quantum;
+}
+
+static inline void rr_on_arrival(SchedulerCore* core HOOK_UNUSED, RrState* state, Process* process) {
+    enqueue(&state->ready, process);
+}
+
+static inline Process* rr_pick_next(SchedulerCore* core HOOK_UNUSED, RrState* state, int* level HOOK_UNUSED, uint64_t* quantum) {
+    *quantum = state->quantum;
+    return dequeue(&state->ready);
+}
+
+static inline void rr_on_slice_end(SchedulerCore* core HOOK_UNUSED, RrState* state, Process* process, int level HOOK_UNUSED, SliceResult* slice) {
+    if (slice->outcome != SLICE_EXITED) {
+        enqueue(&state->ready, process);
+    }
+}
+
+static inline void rr_on_complete(SchedulerCore* core, RrState* state HOOK_UNUSED, Process* process) {
+    write_to_csv(&core->csv, *process);
+}
+
+static inline void rr_destroy(SchedulerCore* core HOOK_UNUSED, RrState* state HOOK_UNUSED) {
+}
+
+// Multi-level Feedback Queue (MLFQ), three levels unless configured
+// otherwise (see level_queues.h). Offline jobs start at the top level,
+// online and simulated ones at the level their command's history suggests.
+
+#define MLFQ_CSV_HEADER RESULT_CSV_HEADER
+#define MLFQ_PREEMPTIVE 0
+
+typedef struct {
+    LevelQueues levels;
+    int quanta[MLFQ_MAX_LEVELS];  // Retuned as slices complete when SCHEDULER_MLFQ_TUNE is set
+    int boost_time;
+    uint64_t last_boost_time;
+    MlfqTuner tuner;
+} MlfqState;
+
+static inline void mlfq_init(SchedulerCore* core HOOK_UNUSED, MlfqState* state, SchedulerPolicy policy HOOK_UNUSED, const SchedulerParams* params) {
+    init_level_queues(&state->levels, mlfq_levels_from_env(state->quanta, params->quantum0, params->quantum1, params->quantum2));
+    state->boost_time = params->boost_time;
+    state->last_boost_time = 0;
+    mlfq_tuner_init(&state->tuner, state->levels.count);
+}
+
+static inline void mlfq_on_arrival(SchedulerCore* core, MlfqState* state, Process* process) {
+    int level = (core->mode != SCHEDULER_OFFLINE) ? get_priority(*process, state->quanta, state->levels.count) : 0;
+    push_level(&state->levels, level, process);
+}
+
+static inline Process* mlfq_pick_next(SchedulerCore* core, MlfqState* state, int* level, uint64_t* quantum) {
+    if (core->current_time - state->last_boost_time >= state->boost_time * NS_PER_MS) {
+        boost_priorities(&state->levels, &state->last_boost_time, core->current_time);
+        log_priority_boost(&core->context_switches, 0, core->current_time);
+    }
+    Process* process = pop_highest(&state->levels, level);
+    if (process == NULL) {
+        return NULL;
+    }
+    *quantum = state->quanta[*level];
+    if (!process->started) {
+        mlfq_tuner_response(&state->tuner, core->current_time - process->arrival_time);
+    }
+    return process;
+}
+
+static inline void mlfq_on_slice_end(SchedulerCore* core, MlfqState* state, Process* process, int level, SliceResult* slice) {
+    if (slice->outcome != SLICE_EXITED) {
+        // Drop the priority
+        push_level(&state->levels, (level < state->levels.count - 1) ? level + 1 : level, process);
+    }
+    mlfq_tuner_slice(&state->tuner, level, slice->outcome == SLICE_EXITED, slice->elapsed_ns, core->current_time,
+                     state->quanta, &state->boost_time);
+}
+
+static inline void mlfq_on_complete(SchedulerCore* core, MlfqState* state HOOK_UNUSED, Process* process) {
+    write_to_csv(&core->csv, *process);
+}
+
+static inline void mlfq_destroy(SchedulerCore* core HOOK_UNUSED, MlfqState* state HOOK_UNUSED) {
+}
+
+// Shortest Job First (SJF), by the expected burst of each job's command
+
+#define SJF_CSV_HEADER RESULT_CSV_HEADER
+#define SJF_PREEMPTIVE 0
+
+static inline void sjf_init(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED, SchedulerPolicy policy HOOK_UNUSED, const SchedulerParams* params HOOK_UNUSED) {
+}
+
+static inline void sjf_on_arrival(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED, Process* process) {
+    add_ready_job(process);
+}
+
+static inline Process* sjf_pick_next(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED, int* level HOOK_UNUSED, uint64_t* quantum HOOK_UNUSED) {
+    return get_shortest_job();
+}
+
+static inline void sjf_on_slice_end(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED, Process* process, int level HOOK_UNUSED, SliceResult* slice) {
+    if (slice->outcome != SLICE_EXITED) {
+        add_ready_job(process);  // Only if the slice engine failed
+    }
+}
+
+static inline void sjf_on_complete(SchedulerCore* core, NoPolicyState* state HOOK_UNUSED, Process* process) {
+    write_to_csv(&core->csv, *process);
+}
+
+static inline void sjf_destroy(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED) {
+}
+
+// Shortest Remaining Time First (SRTF). An arrival pauses the running
+// job's slice, which goes on unless the newcomer is expected to finish
+// sooner.
+
+#define SRTF_CSV_HEADER RESULT_CSV_HEADER
+#define SRTF_PREEMPTIVE 1
+
+static inline void srtf_init(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED, SchedulerPolicy policy HOOK_UNUSED, const SchedulerParams* params HOOK_UNUSED) {
+}
+
+static inline void srtf_on_arrival(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED, Process* process) {
+    add_srtf_job(process);
+}
+
+static inline Process* srtf_pick_next(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED, int* level HOOK_UNUSED, uint64_t* quantum HOOK_UNUSED) {
+    Process* shortest = peek_srtf_job();
+    if (shortest != NULL) {
+        take_srtf_job(shortest);
+    }
+    return shortest;
+}
+
+static inline bool srtf_preempts(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED, Process* process) {
+    Process* shortest = peek_srtf_job();
+    return shortest != NULL && predicted_remaining_time(shortest) < predicted_remaining_time(process);
+}
+
+static inline void srtf_on_slice_end(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED, Process* process, int level HOOK_UNUSED, SliceResult* slice) {
+    if (slice->outcome != SLICE_EXITED) {
+        add_srtf_job(process);
+    }
+}
+
+static inline void srtf_on_complete(SchedulerCore* core, NoPolicyState* state HOOK_UNUSED, Process* process) {
+    refresh_srtf_command(process->command_id);
+    write_to_csv(&core->csv, *process);
+}
+
+static inline void srtf_destroy(SchedulerCore* core HOOK_UNUSED, NoPolicyState* state HOOK_UNUSED) {
+}
+
+// Completely Fair Scheduler (CFS), see cfs_queue.h. Jobs are identified by
+// their process table slot.
+
+#define CFS_CSV_HEADER RESULT_CSV_HEADER
+#define CFS_PREEMPTIVE 0
+
+typedef struct {
+    CfsQueue cfs;
+} CfsState;
+
+static inline void cfs_init(SchedulerCore* core HOOK_UNUSED, CfsState* state, SchedulerPolicy policy HOOK_UNUSED, const SchedulerParams* params HOOK_UNUSED) {
+    init_cfs_queue(&state->cfs);
+}
+
+static inline void cfs_on_arrival(SchedulerCore* core HOOK_UNUSED, CfsState* state, Process* process) {
+    cfs_enqueue(&state->cfs, process->slot, process);
+}
+
+static inline Process* cfs_pick_next(SchedulerCore* core HOOK_UNUSED, CfsState* state, int* level HOOK_UNUSED, uint64_t* quantum) {
+    Process* process = cfs_pick(&state->cfs);
+    if (process != NULL) {
+        *quantum = cfs_slice(&state->cfs, process);
+    }
+    return process;
+}
+
+static inline void cfs_on_slice_end(SchedulerCore* core HOOK_UNUSED, CfsState* state, Process* process, int level HOOK_UNUSED, SliceResult* slice) {
+    cfs_account(&state->cfs, process, slice->elapsed_ns);
+    if (slice->outcome != SLICE_EXITED) {
+        cfs_enqueue(&state->cfs, process->slot, process);
+    }
+}
+
+static inline void cfs_on_complete(SchedulerCore* core, CfsState* state HOOK_UNUSED, Process* process) {
+    write_to_csv(&core->csv, *process);
+}
+
+static inline void cfs_destroy(SchedulerCore* core HOOK_UNUSED, CfsState* state) {
+    free_cfs_queue(&state->cfs);
+}
+
+// Stride scheduling, or lottery scheduling for POLICY_LOTTERY, see
+// share_queue.h. Jobs are identified by their process table slot.
+
+#define SHARE_CSV_HEADER RESULT_SHARE_CSV_HEADER
+#define SHARE_PREEMPTIVE 0
+
+typedef struct {
+    ShareQueue share;
+    int quantum;
+} ShareState;
+
+static inline void share_init(SchedulerCore* core HOOK_UNUSED, ShareState* state, SchedulerPolicy policy, const SchedulerParams* params) {
+    init_share_queue(&state->share, policy == POLICY_LOTTERY);
+    state->quantum = params->quantum;
+}
+
+static inline void share_on_arrival(SchedulerCore* core HOOK_UNUSED, ShareState* state, Process* process) {
+    share_arrive(&state->share, process->slot, process);
+    share_enqueue(&state->share, process->slot, process);
+}
+
+static inline Process* share_pick_next(SchedulerCore* core HOOK_UNUSED, ShareState* state, int* level HOOK_UNUSED, uint64_t* quantum) {
+    int slot;
+    *quantum = state->quantum;
+    return share_pick(&state->share, &slot);
+}
+
+static inline void share_on_slice_end(SchedulerCore* core HOOK_UNUSED, ShareState* state, Process* process, int level HOOK_UNUSED, SliceResult* slice) {
+    share_account(&state->share, process, slice->elapsed_ns);
+    if (slice->outcome != SLICE_EXITED) {
+        share_enqueue(&state->share, process->slot, process);
+    }
+}
+
+static inline void share_on_complete(SchedulerCore* core, ShareState* state, Process* process) {
+    write_share_to_csv(&core->csv, *process, share_tickets(process),
+                       share_entitled_time(&state->share, process->slot, process));
+}
+
+static inline void share_destroy(SchedulerCore* core HOOK_UNUSED, ShareState* state) {
+    free_share_queue(&state->share);
+}
+
+// Earliest Deadline First (EDF), see deadline_queue.h. An arrival pauses
+// the running job's slice, which goes on unless the newcomer has an
+// earlier deadline. Jobs are identified by their process table slot.
+
+#define EDF_CSV_HEADER RESULT_DEADLINE_CSV_HEADER
+#define EDF_PREEMPTIVE 1
+
+typedef struct {
+    DeadlineQueue edf;
+} EdfState;
+
+static inline void edf_init(SchedulerCore* core HOOK_UNUSED, EdfState* state, SchedulerPolicy policy HOOK_UNUSED, const SchedulerParams* params HOOK_UNUSED) {
+    init_deadline_queue(&state->edf);
+}
+
+// The admission check counts the job on the CPU when an arrival paused its
+// slice; between slices that job is already back in the ready set
+static inline void edf_on_arrival(SchedulerCore* core, EdfState* state, Process* process) {
+    if (!admit_edf_job(&state->edf, process, core->running, core->current_time)) {
+        write_deadline_to_csv(&core->csv, *process, true);
+        scheduler_release_job(core, process);
+    }
+}
+
+static inline Process* edf_pick_next(SchedulerCore* core HOOK_UNUSED, EdfState* state, int* level HOOK_UNUSED, uint64_t* quantum HOOK_UNUSED) {
+    return deadline_pick(&state->edf);
+}
+
+static inline bool edf_preempts(SchedulerCore* core HOOK_UNUSED, EdfState* state, Process* process) {
+    Process* earliest = deadline_peek(&state->edf);
+    return earliest != NULL && deadline_key(earliest) < deadline_key(process);
+}
+
+static inline void edf_on_slice_end(SchedulerCore* core HOOK_UNUSED, EdfState* state, Process* process, int level HOOK_UNUSED, SliceResult* slice) {
+    if (slice->outcome != SLICE_EXITED) {
+        deadline_enqueue(&state->edf, process->slot, process, edf_predicted_time(process));
+    }
+}
+
+static inline void edf_on_complete(SchedulerCore* core, EdfState* state, Process* process) {
+    deadline_complete(&state->edf, process);
+    write_deadline_to_csv(&core->csv, *process, false);
+}
+
+static inline void edf_destroy(SchedulerCore* core HOOK_UNUSED, EdfState* state) {
+    print_deadline_stats(&state->edf.stats, stderr);
+    free_deadline_queue(&state->edf);
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+// Ready set of the proportional-share schedulers. Every job holds tickets,
+// and under contention gets the CPU in proportion to them.
+//
+// Stride scheduling is deterministic: a job's pass advances by the time it
+// ran times STRIDE_ONE / tickets, and the ready job with the lowest pass
+// runs next, from a heap keyed by pass. A job joining the queue starts one
+// stride past the global pass, which advances as if a single job held all
+// the runnable tickets, so it neither owes nor is owed CPU time.
+//
+// Lottery scheduling draws the next job at random, each ready ticket
+// having the same chance, from a Fenwick tree of the ready tickets by id.
+// Set SCHEDULER_LOTTERY_SEED for another sequence of draws.
+//
+// Both are O(log n) per pick. The CPU time each job's tickets entitled it
+// to is tracked with one running sum, time per runnable ticket, so that
+// share_entitled_time() can report it at completion.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "process.h"
+#include "clock.h"
+#include "ready_heap.h"
+
+#define STRIDE_ONE (UINT64_C(1) << 20)
+#define DEFAULT_TICKETS 100
+#define MAX_TICKETS 1000000  // Keeps every stride above zero
+
+typedef struct {
+    bool lottery;
+    ReadyHeap ready;           // Stride: ids keyed by pass
+    uint64_t *tree;            // Lottery: Fenwick tree of ready tickets, 1-based
+    uint32_t *held;            // Lottery: id -> tickets while ready, else 0
+    Process **jobs;            // Id -> job
+    double *joined;            // Id -> time_per_ticket when the job arrived
+    int capacity;              // Ids addressable, a power of two
+    int size;                  // Ready jobs
+    uint64_t ready_tickets;
+    uint64_t global_pass;
+    double time_per_ticket;    // ns of CPU each runnable ticket was entitled to so far
+    uint64_t random;           // xorshift64 state
+} ShareQueue;
+
+// Tickets of a job, DEFAULT_TICKETS unless set
+int share_tickets(Process* process) {
+    return process->tickets > 0 ? process->tickets : DEFAULT_TICKETS;
+}
+
+static uint64_t share_stride(Process* process) {
+    return STRIDE_ONE / share_tickets(process);
+}
+
+void init_share_queue(ShareQueue* queue, bool lottery) {
+    memset(queue, 0, sizeof(ShareQueue));
+    queue->lottery = lottery;
+    const char* seed = getenv("SCHEDULER_LOTTERY_SEED");
+    queue->random = (seed != NULL && seed[0] != '\0') ? strtoull(seed, NULL, 10) : 1;
+    if (queue->random == 0) {
+        queue->random = 1;  // xorshift never leaves 0
+    }
+}
+
+void free_share_queue(ShareQueue* queue) {
+    free_ready_heap(&queue->ready);
+    free(queue->tree);
+    free(queue->held);
+    free(queue->jobs);
+    free(queue->joined);
+    memset(queue, 0, sizeof(ShareQueue));
+}
+
+static void share_tree_add(ShareQueue* queue, int id, int64_t tickets) {
+    for (int i = id + 1; i <= queue->capacity; i += i & -i) {
+        queue->tree[i] += tickets;
+    }
+}
+
+// Makes ids below id addressable, rebuilding the lottery tree
+static void share_reserve(ShareQueue* queue, int id) {
+    if (id < queue->capacity) {
+        return;
+    }
+    int old_capacity = queue->capacity;
+    int new_capacity = old_capacity ? old_capacity : 64;
+    while (new_capacity <= id) {
+        new_capacity *= 2;
+    }
+    queue->jobs = (Process**)realloc(queue->jobs, sizeof(Process*) * new_capacity);
+    memset(queue->jobs + old_capacity, 0, sizeof(Process*) * (new_capacity - old_capacity));
+    queue->joined = (double*)realloc(queue->joined, sizeof(double) * new_capacity);
+    queue->capacity = new_capacity;
+    if (queue->lottery) {
+        queue->held = (uint32_t*)realloc(queue->held, sizeof(uint32_t) * new_capacity);
+        memset(queue->held + old_capacity, 0, sizeof(uint32_t) * (new_capacity - old_capacity));
+        free(queue->tree);
+        queue->tree = (uint64_t*)calloc(new_capacity + 1, sizeof(uint64_t));
+        for (int i = 0; i < old_capacity; i++) {
+            if (queue->held[i] > 0) {
+                share_tree_add(queue, i, queue->held[i]);
+            }
+        }
+    }
+}
+
+// Records the arrival of a job under id, which it keeps until it completes
+void share_arrive(ShareQueue* queue, int id, Process* process) {
+    share_reserve(queue, id);
+    queue->joined[id] = queue->time_per_ticket;
+    process->pass = queue->global_pass + share_stride(process);
+}
+
+// Makes an arrived job ready
+void share_enqueue(ShareQueue* queue, int id, Process* process) {
+    share_reserve(queue, id);
+    queue->jobs[id] = process;
+    queue->ready_tickets += share_tickets(process);
+    queue->size++;
+    if (queue->lottery) {
+        queue->held[id] = share_tickets(process);
+        share_tree_add(queue, id, queue->held[id]);
+    } else {
+        ready_heap_update(&queue->ready, id, process->pass, process->process_id);
+    }
+}
+
+static uint64_t share_random(ShareQueue* queue) {
+    queue->random ^= queue->random << 13;
+    queue->random ^= queue->random >> 7;
+    queue->random ^= queue->random << 17;
+    return queue->random;
+}
+
+// Removes and returns the next job to run, storing its id in *id, or NULL
+Process* share_pick(ShareQueue* queue, int* id) {
+    if (queue->size == 0) {
+        return NULL;
+    }
+    if (queue->lottery) {
+        // Descend to the id holding the winning ticket
+        uint64_t winner = share_random(queue) % queue->ready_tickets;
+        int index = 0;
+        for (int step = queue->capacity; step > 0; step /= 2) {
+            if (index + step <= queue->capacity && queue->tree[index + step] <= winner) {
+                index += step;
+                winner -= queue->tree[index];
+            }
+        }
+        *id = index;
+        share_tree_add(queue, index, -(int64_t)queue->held[index]);
+        queue->held[index] = 0;
+    } else {
+        *id = ready_heap_top(&queue->ready);
+        ready_heap_remove(&queue->ready, *id);
+    }
+    Process* process = queue->jobs[*id];
+    queue->ready_tickets -= share_tickets(process);
+    queue->size--;
+    return process;
+}
+
+// Charges a slice of elapsed_ns to the job that ran it, which is not in
+// the queue at this point
+void share_account(ShareQueue* queue, Process* running, uint64_t elapsed_ns) {
+    uint64_t runnable = queue->ready_tickets + share_tickets(running);
+    running->pass += elapsed_ns * share_stride(running) / NS_PER_MS;
+    queue->global_pass += elapsed_ns * STRIDE_ONE / runnable / NS_PER_MS;
+    queue->time_per_ticket += (double)elapsed_ns / runnable;
+}
+
+// CPU time a job's tickets entitled it to since it arrived, in ns
+uint64_t share_entitled_time(ShareQueue* queue, int id, Process* process) {
+    return (uint64_t)(share_tickets(process) * (queue->time_per_ticket - queue->joined[id]));
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// Discrete-event simulation of the scheduling policies. Jobs declare their
+// arrival time and CPU demand (in ns) up front and run against a virtual
+// clock, so no process is ever started. A simulation is the dispatch core in
+// its simulated mode: the same loop, policy hooks, job records, burst
+// history, CSV and context-switch writers as a real run, with a slice that
+// only advances the clock by the time the job would have held the CPU.
+//
+// Only two kinds of event exist on a single CPU: arrivals and the end of the
+// running slice. Arrivals are sorted once up front, so the event queue is
+// that list merged with the one slice in flight.
+#include "scheduler.h"
+
+// Simulates the jobs under policy and writes result_sim_<policy>.csv.
+// RR, stride and lottery use quantum0; MLFQ places new jobs with
+// get_priority, like online mode; SJF, SRTF, CFS and EDF ignore the quanta.
+SimStats Simulate(SimJob jobs[], int n, SchedulerPolicy policy, int quantum0, int quantum1, int quantum2, int boostTime) {
+    SchedulerParams params = {quantum0, quantum0, quantum1, quantum2, boostTime};
+    SchedulerSource source = {.sim_jobs = jobs, .n = n};
+    SimStats stats = {0};
+    dispatch_scheduler(policy, SCHEDULER_SIMULATED, &params, &source, &stats);
+    return stats;
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+// Event-driven time-slice engine shared by the preemptive schedulers.
+// Instead of polling the child every millisecond, the scheduler sleeps in
+// epoll_wait until either the quantum timer fires or the child's pidfd
+// becomes readable (the child exited).
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <stdint.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include "clock.h"
+#include "job_control.h"
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+// Quantum (in ms) for a slice that only ends on exit or input
+#define SLICE_UNLIMITED UINT64_MAX
+
+// Wake time (in ns) of a slice that is never paused for an arrival
+#define SLICE_NO_WAKE UINT64_MAX
+
+// Input descriptors a slice can be interrupted by
+#define SLICE_MAX_INPUTS 2
+
+// How a slice ended
+typedef enum {
+    SLICE_EXPIRED,     // Quantum ran out, the child has been stopped
+    SLICE_EXITED,      // Child terminated, status holds its wait status
+    SLICE_INTERRUPTED  // Input arrived or the wake time came, see begin_slice()
+} SliceOutcome;
+
+typedef struct {
+    SliceOutcome outcome;
+    int status;
+    uint64_t elapsed_ns;  // Time the child actually held the CPU in this slice
+    uint64_t cpu_ns;      // CPU time the child has consumed since it started
+} SliceResult;
+
+typedef struct {
+    int epoll_fd;
+    int timer_fd;
+    bool use_pidfd;  // False when the kernel has no pidfd support
+    int input_fds[SLICE_MAX_INPUTS];  // Interrupt slices when readable
+    int input_count;
+
+    // Slice in flight, see begin_slice()
+    pid_t pid;
+    int pidfd;          // -1 without pidfd support
+    uint64_t mark;      // Time the slice has been accounted up to
+    uint64_t deadline;  // End of the quantum, UINT64_MAX for none
+} SliceEngine;
+
+// Set from a signal handler to end the running slice as if input had
+// arrived, see scheduler_core.h
+volatile sig_atomic_t slice_stop_requested = 0;
+
+// Identifiers stored in epoll_event.data
+#define SLICE_EVENT_TIMER 1
+#define SLICE_EVENT_CHILD 2
+#define SLICE_EVENT_INPUT 3
+
+// Sets up the epoll instance and the quantum timer
+int slice_engine_init(SliceEngine* engine) {
+    engine->input_count = 0;
+    engine->pidfd = -1;
+    engine->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    engine->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (engine->epoll_fd < 0 || engine->timer_fd < 0) {
+        perror("Error creating slice engine");
+        return -1;
+    }
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.u32 = SLICE_EVENT_TIMER};
+    if (epoll_ctl(engine->epoll_fd, EPOLL_CTL_ADD, engine->timer_fd, &ev) < 0) {
+        perror("Error registering quantum timer");
+        return -1;
+    }
+
+    // Probe pidfd support once with our own pid
+    int probe = syscall(SYS_pidfd_open, getpid(), 0);
+    engine->use_pidfd = probe >= 0;
+    if (probe >= 0) close(probe);
+    return 0;
+}
+
+// Makes slices end early with SLICE_INTERRUPTED whenever fd is readable,
+// so preemptive schedulers can react to arrivals immediately
+int slice_engine_watch_input(SliceEngine* engine, int fd) {
+    struct epoll_event ev = {.events = EPOLLIN, .data.u32 = SLICE_EVENT_INPUT};
+    if (engine->input_count == SLICE_MAX_INPUTS || epoll_ctl(engine->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("Error watching input");
+        return -1;
+    }
+    engine->input_fds[engine->input_count++] = fd;
+    return 0;
+}
+
+// Stops watching fd, e.g. once it has reached end of file
+void slice_engine_unwatch_input(SliceEngine* engine, int fd) {
+    for (int i = 0; i < engine->input_count; i++) {
+        if (engine->input_fds[i] == fd) {
+            epoll_ctl(engine->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+            engine->input_fds[i] = engine->input_fds[--engine->input_count];
+            return;
+        }
+    }
+}
+
+void slice_engine_destroy(SliceEngine* engine) {
+    if (engine->timer_fd >= 0) close(engine->timer_fd);
+    if (engine->epoll_fd >= 0) close(engine->epoll_fd);
+}
+
+// Arms (ns > 0) or disarms (ns == 0) the one-shot quantum timer
+static void slice_arm_timer(SliceEngine* engine, uint64_t ns) {
+    // Drop a stale expiration left over from an earlier wait
+    uint64_t expirations;
+    while (read(engine->timer_fd, &expirations, sizeof(expirations)) > 0) {}
+
+    struct itimerspec its = {0};
+    its.it_value.tv_sec = ns / NS_PER_SEC;
+    its.it_value.tv_nsec = ns % NS_PER_SEC;
+    timerfd_settime(engine->timer_fd, 0, &its, NULL);
+}
+
+// Waits until the quantum ends, the wake time comes, watched input arrives,
+// slice_stop_requested is set or the child exits, which reaps it
+static void slice_wait(SliceEngine* engine, uint64_t wake, SliceResult* result) {
+    uint64_t now = clock_ns();
+    uint64_t until = engine->deadline;
+    if (wake != SLICE_NO_WAKE && now + wake < until) {
+        until = now + wake;
+    }
+    result->outcome = SLICE_INTERRUPTED;
+    struct rusage usage;
+
+    if (engine->pidfd < 0) {
+        // Without pidfd support: the old 1ms polling loop
+        while ((now = clock_ns()) < until) {
+            struct pollfd inputs[SLICE_MAX_INPUTS];
+            for (int i = 0; i < engine->input_count; i++) {
+                inputs[i] = (struct pollfd){.fd = engine->input_fds[i], .events = POLLIN};
+            }
+            int ready = poll(inputs, engine->input_count, 1);  // Sleeps 1ms
+            if (wait4(engine->pid, &result->status, WNOHANG, &usage) != 0) {
+                result->outcome = SLICE_EXITED;
+                result->cpu_ns = rusage_cpu_ns(&usage);
+                return;
+            }
+            if (ready > 0 || slice_stop_requested) {
+                return;
+            }
+        }
+        result->outcome = (now >= engine->deadline) ? SLICE_EXPIRED : SLICE_INTERRUPTED;
+        return;
+    }
+
+    slice_arm_timer(engine, (until == UINT64_MAX) ? 0 : (until > now) ? until - now : 1);
+    while (!slice_stop_requested) {
+        struct epoll_event events[2 + SLICE_MAX_INPUTS];
+        int ready = epoll_wait(engine->epoll_fd, events, 2 + SLICE_MAX_INPUTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;  // Rechecks slice_stop_requested
+            perror("Error waiting for slice");
+            return;
+        }
+        for (int e = 0; e < ready; e++) {
+            if (events[e].data.u32 == SLICE_EVENT_CHILD) {
+                wait4(engine->pid, &result->status, 0, &usage);
+                result->outcome = SLICE_EXITED;
+                result->cpu_ns = rusage_cpu_ns(&usage);
+                return;
+            }
+        }
+        for (int e = 0; e < ready; e++) {
+            if (events[e].data.u32 == SLICE_EVENT_TIMER && clock_ns() >= engine->deadline) {
+                result->outcome = SLICE_EXPIRED;
+            }
+        }
+        return;
+    }
+}
+
+// Ends a wait of the slice in flight. A child that exited meanwhile is
+// reaped; one still running is stopped unless keep_running is set. Measures
+// the time since the last mark, and closes the slice unless the child was
+// left running.
+static void slice_settle(SliceEngine* engine, SliceResult* result, bool keep_running) {
+    struct rusage usage;
+    if (result->outcome != SLICE_EXITED) {
+        // The child may have exited right as the timer fired
+        if (wait4(engine->pid, &result->status, WNOHANG, &usage) == 0) {
+            if (!keep_running) {
+                job_stop(engine->pid);  // Job did not end within the slice
+            }
+            result->cpu_ns = child_cpu_time_ns(engine->pid);
+        } else {
+            result->outcome = SLICE_EXITED;
+            result->cpu_ns = rusage_cpu_ns(&usage);
+        }
+    }
+
+    uint64_t now = clock_ns();
+    result->elapsed_ns = now - engine->mark;
+    engine->mark = now;
+    if (keep_running && result->outcome == SLICE_INTERRUPTED) {
+        return;
+    }
+    if (engine->pidfd >= 0) {
+        slice_arm_timer(engine, 0);
+        close(engine->pidfd);  // Also removes it from the epoll set
+        engine->pidfd = -1;
+    }
+    if (result->outcome == SLICE_EXITED) {
+        job_release(engine->pid);
+    }
+}
+
+// Resumes the job led by pid and runs it for at most quantum ms. Returns
+// when the quantum expires (job stopped again) or as soon as the child
+// exits (child reaped, its CPU time taken from wait4). Watched input, the
+// wake time (ns from now, SLICE_NO_WAKE for none) or slice_stop_requested
+// pause the slice instead: it comes back SLICE_INTERRUPTED with the job
+// still running, and the caller either goes on with continue_slice() or
+// ends it with stop_slice(). elapsed_ns is the time since the slice began
+// or was last paused. A pid that failed to launch (<= 0) is reported as
+// exited with status 127, like a shell that could not run the command.
+SliceResult begin_slice(SliceEngine* engine, pid_t pid, uint64_t quantum, uint64_t wake) {
+    SliceResult result = {.outcome = SLICE_EXPIRED, .status = 0};
+    if (pid <= 0) {
+        result.outcome = SLICE_EXITED;
+        result.status = 127 << 8;
+        return result;
+    }
+    engine->pid = pid;
+    engine->pidfd = engine->use_pidfd ? syscall(SYS_pidfd_open, pid, 0) : -1;
+    engine->mark = clock_ns();
+    engine->deadline = (quantum == SLICE_UNLIMITED) ? UINT64_MAX : engine->mark + (quantum > 0 ? quantum : 1) * NS_PER_MS;
+    job_resume(pid);  // Resume the whole job
+    if (engine->pidfd >= 0) {
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = SLICE_EVENT_CHILD};
+        epoll_ctl(engine->epoll_fd, EPOLL_CTL_ADD, engine->pidfd, &ev);
+    }
+    slice_wait(engine, wake, &result);
+    slice_settle(engine, &result, true);
+    return result;
+}
+
+// Goes on with a slice paused by begin_slice(), within the same quantum,
+// without stopping or resuming the job
+SliceResult continue_slice(SliceEngine* engine, uint64_t wake) {
+    SliceResult result = {.outcome = SLICE_EXPIRED, .status = 0};
+    slice_wait(engine, wake, &result);
+    slice_settle(engine, &result, true);
+    return result;
+}
+
+// Ends a paused slice and stops the job, which is then reported as
+// SLICE_INTERRUPTED, or SLICE_EXITED if it exited meanwhile
+SliceResult stop_slice(SliceEngine* engine) {
+    SliceResult result = {.outcome = SLICE_INTERRUPTED, .status = 0};
+    slice_settle(engine, &result, false);
+    return result;
+}
+
+// Runs a whole slice, see begin_slice(); one paused by input is stopped at
+// once, and the job stopped
+SliceResult run_slice(SliceEngine* engine, pid_t pid, uint64_t quantum) {
+    SliceResult result = begin_slice(engine, pid, quantum, SLICE_NO_WAKE);
+    if (result.outcome == SLICE_INTERRUPTED) {
+        uint64_t elapsed = result.elapsed_ns;
+        result = stop_slice(engine);
+        result.elapsed_ns += elapsed;
+    }
+    return result;
+}
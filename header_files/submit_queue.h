@@ -0,0 +1,63 @@
+#pragma once
+
+// Lock-free multi-producer, single-consumer queue of submitted commands.
+// Producers push onto an atomic stack with a CAS loop; the scheduler takes
+// the whole stack with one exchange and reverses it, so a drain costs one
+// atomic operation however many jobs arrived, and jobs come out in the
+// order they were pushed.
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "clock.h"
+
+typedef struct Submission {
+    struct Submission *next;
+    uint64_t arrival_ns;  // clock_ns() when the producer received the command
+    char command[];
+} Submission;
+
+typedef struct {
+    _Atomic(Submission*) top;  // Most recent push first
+} SubmitQueue;
+
+// Copies command and pushes it, stamped with the current time. Safe to call
+// from any number of threads.
+int submit_queue_push(SubmitQueue* queue, const char* command, size_t len) {
+    Submission* submission = (Submission*)malloc(sizeof(Submission) + len + 1);
+    if (submission == NULL) {
+        return -1;
+    }
+    memcpy(submission->command, command, len);
+    submission->command[len] = '\0';
+    submission->arrival_ns = clock_ns();
+
+    Submission* top = atomic_load_explicit(&queue->top, memory_order_relaxed);
+    do {
+        submission->next = top;
+    } while (!atomic_compare_exchange_weak_explicit(&queue->top, &top, submission,
+                                                    memory_order_release, memory_order_relaxed));
+    return 0;
+}
+
+// Takes every pending submission, oldest first, or NULL if there are none.
+// Only the consumer may call this; it owns the returned list.
+Submission* submit_queue_take_all(SubmitQueue* queue) {
+    Submission* top = atomic_exchange_explicit(&queue->top, NULL, memory_order_acquire);
+    Submission* oldest = NULL;
+    while (top != NULL) {
+        Submission* next = top->next;
+        top->next = oldest;
+        oldest = top;
+        top = next;
+    }
+    return oldest;
+}
+
+void free_submissions(Submission* submission) {
+    while (submission != NULL) {
+        Submission* next = submission->next;
+        free(submission);
+        submission = next;
+    }
+}
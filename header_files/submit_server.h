@@ -0,0 +1,225 @@
+#pragma once
+
+// Job submission over a Unix-domain socket, for the online schedulers.
+// Clients connect and write commands, one per line; a connection may carry
+// any number of them. Every connection gets its own reader thread, which
+// pushes the commands into a SubmitQueue and signals wake_fd (an eventfd)
+// once per read() batch. The scheduler watches wake_fd next to stdin and
+// takes everything pending with submit_server_take().
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include "submit_queue.h"
+
+#define SUBMIT_READ_BUFFER 8192
+
+typedef struct {
+    SubmitQueue queue;
+    int listen_fd;
+    int wake_fd;  // Readable while submissions may be pending
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    pthread_t listener;
+
+    pthread_mutex_t lock;  // Guards the client list, never taken by the scheduler
+    pthread_cond_t clients_done;
+    int *client_fds;
+    int client_count;
+    int client_capacity;
+    bool stopping;
+} SubmitServer;
+
+typedef struct {
+    SubmitServer* server;
+    int fd;
+} SubmitClient;
+
+// Pushes one line, skipping blank ones and a trailing carriage return
+static bool submit_line(SubmitServer* server, const char* line, size_t len) {
+    if (len > 0 && line[len - 1] == '\r') len--;
+    if (len == 0) return false;
+    return submit_queue_push(&server->queue, line, len) == 0;
+}
+
+static void submit_wake(SubmitServer* server) {
+    uint64_t one = 1;
+    if (write(server->wake_fd, &one, sizeof(one)) < 0) {
+        // Counter saturated; the scheduler has a wakeup pending anyway
+    }
+}
+
+// Reads commands from one connection until the client closes it
+static void* submit_client_main(void* arg) {
+    SubmitClient client = *(SubmitClient*)arg;
+    free(arg);
+    SubmitServer* server = client.server;
+
+    char buffer[SUBMIT_READ_BUFFER];
+    size_t used = 0;
+    while (1) {
+        ssize_t got = read(client.fd, buffer + used, sizeof(buffer) - used);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        used += got;
+
+        bool pushed = false;
+        size_t line_start = 0;
+        for (size_t i = used - got; i < used; i++) {
+            if (buffer[i] == '\n') {
+                pushed |= submit_line(server, buffer + line_start, i - line_start);
+                line_start = i + 1;
+            }
+        }
+        if (line_start == 0 && used == sizeof(buffer)) {
+            // A line longer than the buffer is submitted as it is
+            pushed |= submit_line(server, buffer, used);
+            line_start = used;
+        }
+        used -= line_start;
+        memmove(buffer, buffer + line_start, used);
+        if (pushed) {
+            submit_wake(server);
+        }
+    }
+    if (submit_line(server, buffer, used)) {
+        submit_wake(server);  // Last line without a newline
+    }
+
+    pthread_mutex_lock(&server->lock);
+    for (int i = 0; i < server->client_count; i++) {
+        if (server->client_fds[i] == client.fd) {
+            server->client_fds[i] = server->client_fds[--server->client_count];
+            break;
+        }
+    }
+    close(client.fd);
+    if (server->client_count == 0) {
+        pthread_cond_signal(&server->clients_done);
+    }
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+// Accepts connections and starts a reader thread for each
+static void* submit_listener_main(void* arg) {
+    SubmitServer* server = (SubmitServer*)arg;
+    while (1) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;  // Shut down by submit_server_stop, or a fatal error
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);  // Jobs must not inherit client connections
+
+        pthread_mutex_lock(&server->lock);
+        if (server->stopping) {
+            pthread_mutex_unlock(&server->lock);
+            close(fd);
+            break;
+        }
+        if (server->client_count == server->client_capacity) {
+            server->client_capacity = server->client_capacity ? server->client_capacity * 2 : 16;
+            server->client_fds = (int*)realloc(server->client_fds, sizeof(int) * server->client_capacity);
+        }
+        server->client_fds[server->client_count++] = fd;
+        pthread_mutex_unlock(&server->lock);
+
+        SubmitClient* client = (SubmitClient*)malloc(sizeof(SubmitClient));
+        client->server = server;
+        client->fd = fd;
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&thread, &attr, submit_client_main, client) != 0) {
+            perror("Error starting submission reader");
+            free(client);
+            pthread_mutex_lock(&server->lock);
+            server->client_count--;  // fd is still the last entry
+            close(fd);
+            pthread_mutex_unlock(&server->lock);
+        }
+        pthread_attr_destroy(&attr);
+    }
+    return NULL;
+}
+
+// Listens on path, replacing a stale socket file left by an earlier run
+int submit_server_start(SubmitServer* server, const char* path) {
+    memset(server, 0, sizeof(SubmitServer));
+    if (strlen(path) >= sizeof(server->path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(server->path, path);
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->clients_done, NULL);
+
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    strcpy(addr.sun_path, path);
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    server->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    unlink(path);
+    if (server->listen_fd < 0 || server->wake_fd < 0 ||
+        bind(server->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(server->listen_fd, SOMAXCONN) < 0) {
+        perror("Error opening submission socket");
+        if (server->listen_fd >= 0) close(server->listen_fd);
+        if (server->wake_fd >= 0) close(server->wake_fd);
+        return -1;
+    }
+    if (pthread_create(&server->listener, NULL, submit_listener_main, server) != 0) {
+        perror("Error starting submission listener");
+        close(server->listen_fd);
+        close(server->wake_fd);
+        unlink(path);
+        return -1;
+    }
+    return 0;
+}
+
+// Takes every command submitted since the last call, oldest first
+Submission* submit_server_take(SubmitServer* server) {
+    // Clear the wakeup before taking, so a push racing with us signals again
+    uint64_t count;
+    if (read(server->wake_fd, &count, sizeof(count)) < 0) {
+        // Nothing signalled since the last take
+    }
+    return submit_queue_take_all(&server->queue);
+}
+
+// Disconnects every client, waits for the reader threads and removes the
+// socket. Submissions still pending are dropped.
+void submit_server_stop(SubmitServer* server) {
+    pthread_mutex_lock(&server->lock);
+    server->stopping = true;
+    for (int i = 0; i < server->client_count; i++) {
+        shutdown(server->client_fds[i], SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    shutdown(server->listen_fd, SHUT_RDWR);  // Wakes the listener out of accept
+    pthread_join(server->listener, NULL);
+    close(server->listen_fd);
+
+    pthread_mutex_lock(&server->lock);
+    while (server->client_count > 0) {
+        pthread_cond_wait(&server->clients_done, &server->lock);
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    unlink(server->path);
+    close(server->wake_fd);
+    free_submissions(submit_queue_take_all(&server->queue));
+    free(server->client_fds);
+    pthread_mutex_destroy(&server->lock);
+    pthread_cond_destroy(&server->clients_done);
+}
@@ -0,0 +1,307 @@
+#pragma once
+
+// Context-switch tracing. Every slice becomes a fixed-size binary record in
+// an in-memory ring, and a full ring is drained to the trace file with one
+// write(). export_chrome_trace() turns a trace file into Chrome trace-event
+// JSON, which chrome://tracing and Perfetto show on a timeline.
+//
+// Set SCHEDULER_TRACE=<file> to trace a run. Without it the schedulers print
+// the usual command|start|end lines on stdout.
+//
+// trace_export includes this header first; job control needs the GNU
+// affinity calls declared.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "clock.h"
+#include "process.h"
+#include "command_table.h"
+#include "result_sink.h"
+#include "slice_engine.h"
+
+#define TRACE_RING_RECORDS 4096  // Power of two
+#define TRACE_MAGIC "SCHTRACE"
+#define TRACE_VERSION 1
+
+// Why a slice ended
+typedef enum {
+    TRACE_EXPIRED,    // Quantum ran out
+    TRACE_EXITED,     // Job terminated
+    TRACE_PREEMPTED,  // A job expected to finish sooner took the CPU
+    TRACE_BOOST       // Priority boost marker, not a slice
+} TraceReason;
+
+const char* trace_reason_names[] = {"expired", "exited", "preempted", "boost"};
+
+typedef struct {
+    uint64_t start;     // Slice start on the scheduler's timeline, ns
+    uint64_t end;       // Slice end on the scheduler's timeline, ns
+    uint64_t overhead;  // Real time spent in the scheduler since the previous record, ns
+    int32_t job;        // process_id, -1 for boost markers
+    int32_t name;       // Index in the trace's name table
+    uint16_t cpu;
+    uint8_t level;      // Queue level the job ran from
+    uint8_t reason;     // TraceReason
+    uint32_t reserved;
+} TraceRecord;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+} TraceHeader;
+
+// Written after the records: name_count strings, each a uint32 length and
+// the bytes, followed by this footer
+typedef struct {
+    uint64_t record_count;
+    uint64_t names_offset;
+    uint32_t name_count;
+    uint32_t reserved;
+} TraceFooter;
+
+typedef struct {
+    int fd;
+    TraceRecord *ring;
+    uint64_t head;          // Records appended so far
+    uint64_t drained;       // Records already written to the file
+    uint64_t last_clock;    // Real time of the previous record
+    bool virtual_time;      // Slices do not take real time (simulation)
+    CommandTable names;     // Job names, interned once
+} TraceBuffer;
+
+// Writes every buffered record to the trace file
+void drain_trace(TraceBuffer* trace) {
+    uint64_t pending = trace->head - trace->drained;
+    uint64_t first = trace->drained & (TRACE_RING_RECORDS - 1);
+    uint64_t run = (first + pending > TRACE_RING_RECORDS) ? TRACE_RING_RECORDS - first : pending;
+    result_sink_write_all(trace->fd, (const char*)(trace->ring + first), run * sizeof(TraceRecord));
+    result_sink_write_all(trace->fd, (const char*)trace->ring, (pending - run) * sizeof(TraceRecord));
+    trace->drained = trace->head;
+}
+
+// Creates (truncates) the trace file
+int open_trace(TraceBuffer* trace, const char* filename) {
+    memset(trace, 0, sizeof(TraceBuffer));
+    trace->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (trace->fd < 0) {
+        perror("Error opening trace file");
+        return -1;
+    }
+    TraceHeader header = {.version = TRACE_VERSION, .record_size = sizeof(TraceRecord)};
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    result_sink_write_all(trace->fd, (const char*)&header, sizeof(header));
+    trace->ring = (TraceRecord*)malloc(sizeof(TraceRecord) * TRACE_RING_RECORDS);
+    trace->last_clock = clock_ns();
+    return 0;
+}
+
+// Appends one record, draining the ring first when it is full
+void trace_record(TraceBuffer* trace, int job, const char* name, int cpu, int level, TraceReason reason, uint64_t start, uint64_t end) {
+    if (trace->head - trace->drained == TRACE_RING_RECORDS) {
+        drain_trace(trace);
+    }
+    // Real time since the previous record that was not spent in the slice
+    uint64_t now = clock_ns();
+    uint64_t overhead = now - trace->last_clock;
+    if (!trace->virtual_time) {
+        overhead = (overhead > end - start) ? overhead - (end - start) : 0;
+    }
+    trace->last_clock = now;
+
+    TraceRecord* record = &trace->ring[trace->head & (TRACE_RING_RECORDS - 1)];
+    record->start = start;
+    record->end = end;
+    record->overhead = overhead;
+    record->job = job;
+    record->name = intern_command(&trace->names, name);
+    record->cpu = cpu;
+    record->level = level;
+    record->reason = reason;
+    record->reserved = 0;
+    trace->head++;
+}
+
+// Drains the ring, appends the name table and footer, and closes the file
+void close_trace(TraceBuffer* trace) {
+    if (trace->ring == NULL) {
+        return;
+    }
+    drain_trace(trace);
+    TraceFooter footer = {.record_count = trace->head, .name_count = trace->names.count};
+    footer.names_offset = sizeof(TraceHeader) + trace->head * sizeof(TraceRecord);
+    for (int i = 0; i < trace->names.count; i++) {
+        uint32_t len = strlen(trace->names.commands[i]);
+        result_sink_write_all(trace->fd, (const char*)&len, sizeof(len));
+        result_sink_write_all(trace->fd, trace->names.commands[i], len);
+    }
+    result_sink_write_all(trace->fd, (const char*)&footer, sizeof(footer));
+    close(trace->fd);
+    free(trace->ring);
+    trace->ring = NULL;
+    free_command_table(&trace->names);
+}
+
+// Where the schedulers report context switches: the binary trace when
+// SCHEDULER_TRACE is set, command|start|end lines on stdout otherwise
+typedef struct {
+    bool tracing;
+    TraceBuffer trace;
+    ResultSink text;
+} ContextSwitchLog;
+
+int open_context_switch_log(ContextSwitchLog* log) {
+    const char* filename = getenv("SCHEDULER_TRACE");
+    log->tracing = filename != NULL && filename[0] != '\0';
+    if (log->tracing && open_trace(&log->trace, filename) == 0) {
+        return 0;
+    }
+    log->tracing = false;  // Fall back to the text log
+    return open_result_sink_fd(&log->text, STDOUT_FILENO, false);
+}
+
+void close_context_switch_log(ContextSwitchLog* log) {
+    if (log->tracing) {
+        close_trace(&log->trace);
+    } else {
+        close_result_sink(&log->text);
+    }
+}
+
+// Writes out the buffered context switches, e.g. before the scheduler idles
+void flush_context_switch_log(ContextSwitchLog* log) {
+    if (log->tracing) {
+        drain_trace(&log->trace);
+    } else {
+        flush_result_sink(&log->text);
+    }
+}
+
+// Reports one slice of process on cpu, taken from the given queue level
+void log_context_switch(ContextSwitchLog* log, Process* process, int cpu, int level, TraceReason reason, uint64_t context_switch_start, uint64_t context_switch_end) {
+    if (log->tracing) {
+        trace_record(&log->trace, process->process_id, process->command, cpu, level, reason, context_switch_start, context_switch_end);
+    } else {
+        result_sink_printf(&log->text, "%s|%lu|%lu\n", process->command, context_switch_start / NS_PER_MS, context_switch_end / NS_PER_MS);
+    }
+}
+
+// Marks a priority boost in the trace; the text log has no boost lines
+void log_priority_boost(ContextSwitchLog* log, int cpu, uint64_t time) {
+    if (log->tracing) {
+        trace_record(&log->trace, -1, "boost", cpu, 0, TRACE_BOOST, time, time);
+    }
+}
+
+// Maps how a slice ended to the trace reason
+TraceReason slice_trace_reason(SliceOutcome outcome) {
+    return (outcome == SLICE_EXITED) ? TRACE_EXITED : (outcome == SLICE_EXPIRED) ? TRACE_EXPIRED : TRACE_PREEMPTED;
+}
+
+// Prints a JSON string literal
+void print_json_string(FILE* out, const char* s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fprintf(out, "\\%c", *s);
+        } else if ((unsigned char)*s < 0x20) {
+            fprintf(out, "\\u%04x", *s);
+        } else {
+            fputc(*s, out);
+        }
+    }
+    fputc('"', out);
+}
+
+// Converts a trace file to Chrome trace-event JSON. Each CPU is a thread on
+// the timeline, slices are complete ("X") events and boosts instant events.
+// A trace without its footer (the scheduler was killed) is read up to the
+// last whole record; its jobs are named by process_id.
+int export_chrome_trace(const char* filename, FILE* out) {
+    FILE* in = fopen(filename, "rb");
+    if (in == NULL) {
+        perror("Error opening trace file");
+        return -1;
+    }
+    TraceHeader header;
+    TraceFooter footer;
+    long size = -1;
+    if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TRACE_VERSION || header.record_size != sizeof(TraceRecord) ||
+        fseek(in, 0, SEEK_END) != 0 || (size = ftell(in)) < (long)sizeof(header)) {
+        fprintf(stderr, "%s: not a scheduler trace\n", filename);
+        fclose(in);
+        return -1;
+    }
+    uint64_t body = size - sizeof(header);
+    if (body < sizeof(footer) || fseek(in, -(long)sizeof(footer), SEEK_END) != 0 ||
+        fread(&footer, sizeof(footer), 1, in) != 1 ||
+        footer.names_offset != sizeof(header) + footer.record_count * sizeof(TraceRecord) ||
+        footer.names_offset > (uint64_t)size - sizeof(footer)) {
+        footer = (TraceFooter){.record_count = body / sizeof(TraceRecord)};
+        fprintf(stderr, "%s: trace has no footer, reading %llu records\n", filename,
+                (unsigned long long)footer.record_count);
+    }
+
+    // Name table
+    char** names = (char**)calloc(footer.name_count + 1, sizeof(char*));
+    fseek(in, footer.names_offset, SEEK_SET);
+    for (uint32_t i = 0; i < footer.name_count; i++) {
+        uint32_t len = 0;
+        if (fread(&len, sizeof(len), 1, in) != 1) break;
+        names[i] = (char*)malloc(len + 1);
+        names[i][fread(names[i], 1, len, in)] = '\0';
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fseek(in, sizeof(TraceHeader), SEEK_SET);
+    TraceRecord records[1024];
+    uint64_t remaining = footer.record_count;
+    bool first = true;
+    while (remaining > 0) {
+        size_t want = remaining < 1024 ? remaining : 1024;
+        size_t got = fread(records, sizeof(TraceRecord), want, in);
+        if (got == 0) break;
+        remaining -= got;
+        for (size_t r = 0; r < got; r++) {
+            TraceRecord* record = &records[r];
+            if (record->reason > TRACE_BOOST) continue;
+            char job_name[32];
+            const char* name = job_name;
+            if (record->name >= 0 && (uint32_t)record->name < footer.name_count && names[record->name]) {
+                name = names[record->name];
+            } else if (record->reason == TRACE_BOOST) {
+                name = "boost";
+            } else {
+                snprintf(job_name, sizeof(job_name), "job %d", record->job);
+            }
+            fprintf(out, "%s{\"name\":", first ? "" : ",\n");
+            print_json_string(out, name);
+            if (record->reason == TRACE_BOOST) {
+                fprintf(out, ",\"ph\":\"i\",\"s\":\"p\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+                        record->start / 1000.0, record->cpu);
+            } else {
+                fprintf(out, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u,"
+                        "\"args\":{\"job\":%d,\"level\":%u,\"reason\":\"%s\",\"overhead_us\":%.3f}}",
+                        trace_reason_names[record->reason], record->start / 1000.0, (record->end - record->start) / 1000.0,
+                        record->cpu, record->job, record->level, trace_reason_names[record->reason], record->overhead / 1000.0);
+            }
+            first = false;
+        }
+    }
+    fprintf(out, "\n]}\n");
+
+    for (uint32_t i = 0; i < footer.name_count; i++) {
+        free(names[i]);
+    }
+    free(names);
+    fclose(in);
+    return 0;
+}
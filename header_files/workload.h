@@ -0,0 +1,197 @@
+#pragma once
+
+// Workload files replayed by the offline schedulers: one
+// "<arrival ms> <command>" per line, in arrival order, where the command may
+// start with job options such as [nice=5] or [deadline=2000]. Blank lines
+// and lines starting with # are skipped.
+//
+// Regular files are memory-mapped and read front to back; anything else,
+// such as a pipe, is read through one fixed line buffer. Either way a line
+// is parsed in place and only its command is copied, into the reader's own
+// buffer, so reading a job allocates nothing and a file of millions of jobs
+// is never held in memory as records. The scheduler takes the next job
+// once its clock reaches the job's arrival time.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "clock.h"
+
+#define WORKLOAD_LINE_MAX 1024
+
+typedef struct {
+    const char *path;
+    FILE *stream;       // Set when the file is not mapped
+    const char *data;   // Mapped file
+    size_t size;
+    size_t offset;      // Start of the next line in data
+    uint64_t line_number;
+
+    // Next job, valid while pending is set
+    bool pending;
+    uint64_t arrival_time;  // ns on the scheduler clock
+    char command[WORKLOAD_LINE_MAX];
+
+    uint64_t jobs;       // Jobs read so far
+    uint64_t skipped;    // Malformed lines
+    uint64_t reordered;  // Jobs listed after a later arrival, which arrive with it
+    char line[WORKLOAD_LINE_MAX + 1];  // Stream only
+} WorkloadFile;
+
+// Next raw line, without its newline. Returns false at end of file.
+static bool workload_read_line(WorkloadFile* workload, const char** line, size_t* length) {
+    workload->line_number++;
+    if (workload->stream == NULL) {
+        if (workload->offset >= workload->size) {
+            return false;
+        }
+        const char* start = workload->data + workload->offset;
+        const char* end = (const char*)memchr(start, '\n', workload->size - workload->offset);
+        *line = start;
+        *length = end ? (size_t)(end - start) : workload->size - workload->offset;
+        workload->offset += *length + (end != NULL);
+        return true;
+    }
+    if (fgets(workload->line, sizeof(workload->line), workload->stream) == NULL) {
+        return false;
+    }
+    *line = workload->line;
+    *length = strcspn(workload->line, "\n");
+    if (workload->line[*length] != '\n' && !feof(workload->stream)) {
+        // Too long for the buffer: drop the rest, the length marks it malformed
+        int c;
+        while ((c = fgetc(workload->stream)) != EOF && c != '\n') {}
+        *length = sizeof(workload->line);
+    }
+    return true;
+}
+
+// Parses one line into the pending job. Returns false for lines without one.
+static bool workload_parse(WorkloadFile* workload, const char* line, size_t length) {
+    while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == ' ' || line[length - 1] == '\t')) {
+        length--;
+    }
+    size_t i = 0;
+    while (i < length && (line[i] == ' ' || line[i] == '\t')) i++;
+    if (i == length || line[i] == '#') {
+        return false;
+    }
+
+    uint64_t arrival = 0;
+    size_t digits = i;
+    while (i < length && line[i] >= '0' && line[i] <= '9' && arrival <= UINT64_MAX / NS_PER_MS / 10) {
+        arrival = arrival * 10 + (line[i++] - '0');
+    }
+    bool separated = i < length && (line[i] == ' ' || line[i] == '\t');
+    while (i < length && (line[i] == ' ' || line[i] == '\t')) i++;
+    if (i == digits || !separated || i == length || length - i >= sizeof(workload->command)) {
+        fprintf(stderr, "Skipping line %lu of %s\n", workload->line_number, workload->path);
+        workload->skipped++;
+        return false;
+    }
+
+    memcpy(workload->command, line + i, length - i);
+    workload->command[length - i] = '\0';
+    arrival *= NS_PER_MS;
+    if (workload->jobs > 0 && arrival < workload->arrival_time) {
+        arrival = workload->arrival_time;
+        workload->reordered++;
+    }
+    workload->arrival_time = arrival;
+    workload->jobs++;
+    return true;
+}
+
+// Reads the next job into command and arrival_time. Returns false, and
+// clears pending, at end of file.
+bool workload_advance(WorkloadFile* workload) {
+    const char* line;
+    size_t length;
+    workload->pending = false;
+    while (!workload->pending && workload_read_line(workload, &line, &length)) {
+        workload->pending = workload_parse(workload, line, length);
+    }
+    return workload->pending;
+}
+
+// Opens path, or stdin for "-", and reads the first job. Returns -1 on
+// error.
+int open_workload(WorkloadFile* workload, const char* path) {
+    memset(workload, 0, sizeof(WorkloadFile));
+    workload->path = path;
+    if (strcmp(path, "-") == 0) {
+        workload->stream = stdin;
+        workload_advance(workload);
+        return 0;
+    }
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror("Error opening workload file");
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            workload->data = (const char*)map;
+            workload->size = st.st_size;
+        }
+    }
+    if (workload->data == NULL && !(S_ISREG(st.st_mode) && st.st_size == 0)) {
+        workload->stream = fdopen(fd, "r");
+        if (workload->stream == NULL) {
+            perror("Error opening workload file");
+            close(fd);
+            return -1;
+        }
+    } else {
+        close(fd);  // The mapping stays valid
+    }
+    workload_advance(workload);
+    return 0;
+}
+
+// Starts over from the first job, for another run over the same file.
+// Returns -1 if the file cannot be read again, such as a pipe.
+int rewind_workload(WorkloadFile* workload) {
+    if (workload->stream != NULL && fseek(workload->stream, 0, SEEK_SET) < 0) {
+        return -1;
+    }
+    workload->offset = 0;
+    workload->line_number = 0;
+    workload->jobs = 0;
+    workload->skipped = 0;
+    workload->reordered = 0;
+    workload_advance(workload);
+    return 0;
+}
+
+void close_workload(WorkloadFile* workload) {
+    if (workload->data != NULL) {
+        munmap((void*)workload->data, workload->size);
+    }
+    if (workload->stream != NULL && workload->stream != stdin) {
+        fclose(workload->stream);
+    }
+    memset(workload, 0, sizeof(WorkloadFile));
+}
+
+// Prints how many jobs were read, and the lines that were not taken as given
+void print_workload_stats(WorkloadFile* workload, FILE* out) {
+    fprintf(out, "Workload %s: %lu jobs", workload->path, workload->jobs);
+    if (workload->skipped > 0) {
+        fprintf(out, ", %lu malformed lines skipped", workload->skipped);
+    }
+    if (workload->reordered > 0) {
+        fprintf(out, ", %lu jobs out of arrival order arrived with the job before", workload->reordered);
+    }
+    fprintf(out, "\n");
+}
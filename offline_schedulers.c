@@ -1,7 +1,36 @@
 # include "header_files/offline_schedulers.h"
 
 
-int main() {
+// Replays the workload file at path (see workload.h) under each offline
+// policy and EDF, with the same quanta as the runs below
+int replay_workload(const char* path) {
+    WorkloadFile workload;
+    if (open_workload(&workload, path) < 0) {
+        return 1;
+    }
+    SchedulerParams params = {.quantum = 1000, .quantum0 = 1000, .quantum1 = 2000, .quantum2 = 3000, .boost_time = 5000};
+    SchedulerPolicy policies[] = {POLICY_FCFS, POLICY_RR, POLICY_MLFQ, POLICY_CFS, POLICY_STRIDE, POLICY_LOTTERY, POLICY_EDF};
+    for (int i = 0; i < (int)(sizeof(policies) / sizeof(policies[0])); i++) {
+        const char* name = scheduler_policy_names[policies[i]];
+        if (i > 0 && rewind_workload(&workload) < 0) {
+            fprintf(stderr, "Cannot read %s again, stopping after %s\n", path, scheduler_policy_names[policies[i - 1]]);
+            break;
+        }
+        printf("Running %s Scheduler on %s\n", name, path);
+        run_scheduler_workload(policies[i], &params, &workload);
+        print_workload_stats(&workload, stdout);
+        printf("%s Scheduler completed. Results written to result_offline_%s.csv\n\n", name, name);
+    }
+    close_workload(&workload);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // A workload file replaces the jobs below
+    if (argc == 2) {
+        return replay_workload(argv[1]);
+    }
+
     // Define an array of processes
     Process processes[] = {
         {.command = "sleep 1", .process_id = 1},
@@ -33,9 +62,39 @@ int main() {
 
     // Run Multi-level Feedback Queue scheduler
     printf("Running Multi-level Feedback Queue (MLFQ) Scheduler\n");
-    MultiLevelFeedbackQueue(processes, num_processes, 1000, 2000, 3000, 5000);  // 1s, 2s, 3s quanta, 5s boost
+    OfflineMultiLevelFeedbackQueue(processes, num_processes, 1000, 2000, 3000, 5000);  // 1s, 2s, 3s quanta, 5s boost
     printf("MLFQ Scheduler completed. Results written to result_offline_MLFQ.csv\n\n");
 
+    // Reset process states
+    reset_processes(processes, num_processes);
+
+    // Run Completely Fair Scheduler
+    printf("Running Completely Fair Scheduler (CFS)\n");
+    OfflineCompletelyFairScheduler(processes, num_processes);
+    printf("CFS Scheduler completed. Results written to result_offline_CFS.csv\n\n");
+
+    // Reset process states
+    reset_processes(processes, num_processes);
+
+    // Run Stride and Lottery schedulers
+    printf("Running Stride Scheduler\n");
+    OfflineProportionalShare(processes, num_processes, 1000, false);  // 1000ms (1s) quantum
+    printf("Stride Scheduler completed. Results written to result_offline_Stride.csv\n\n");
+
+    reset_processes(processes, num_processes);
+
+    printf("Running Lottery Scheduler\n");
+    OfflineProportionalShare(processes, num_processes, 1000, true);
+    printf("Lottery Scheduler completed. Results written to result_offline_Lottery.csv\n\n");
+
+    // Reset process states
+    reset_processes(processes, num_processes);
+
+    // Run Multi-level Feedback Queue on every CPU
+    printf("Running Multi-core Multi-level Feedback Queue (MLFQ) Scheduler\n");
+    MultiCoreScheduler(processes, num_processes, 0, DISPATCH_MLFQ, 1000, 2000, 3000, 5000);  // One worker per CPU
+    printf("Multi-core MLFQ Scheduler completed. Results written to result_offline_multicore_MLFQ.csv\n\n");
+
     return 0;
 }
 
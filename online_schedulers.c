@@ -1,11 +1,26 @@
 #include "header_files/online_schedulers.h"
 
 int main() {
+    // Unbuffered, so select() on stdin never misses lines already read into stdio
+    setvbuf(stdin, NULL, _IONBF, 0);
+
+    HistoryFile history;
+    SubmitServer server;
+    if (start_online_services(&history, &server) < 0) {
+        stop_online_services();
+        return 1;
+    }
+
     int choice;
     printf("Choose a scheduling algorithm:\n");
     printf("1. Shortest Job First (SJF)\n");
     printf("2. Multi-level Feedback Queue (MLFQ)\n");
-    printf("Enter your choice (1-2): ");
+    printf("3. Shortest Remaining Time First (SRTF)\n");
+    printf("4. Completely Fair Scheduler (CFS)\n");
+    printf("5. Stride scheduling\n");
+    printf("6. Lottery scheduling\n");
+    printf("7. Earliest Deadline First (EDF)\n");
+    printf("Enter your choice (1-7): ");
     scanf("%d", &choice);  // Read the choice
     getchar();  // Consume the newline character left in the input buffer
 
@@ -27,11 +42,35 @@ int main() {
             scanf("%d", &boostTime);
             MultiLevelFeedbackQueue(quantum0, quantum1, quantum2, boostTime);
             break;
+        case 3:
+            printf("Running Shortest Remaining Time First (SRTF) scheduler\n");
+            ShortestRemainingTimeFirst();
+            break;
+        case 4:
+            printf("Running Completely Fair Scheduler (CFS)\n");
+            CompletelyFairScheduler();
+            break;
+        case 5:
+        case 6:
+            printf("Running %s scheduler\n", (choice == 6) ? "Lottery" : "Stride");
+            int quantum;
+            printf("Enter quantum (ms): ");
+            scanf("%d", &quantum);
+            ProportionalShare(quantum, choice == 6);
+            break;
+        case 7:
+            printf("Running Earliest Deadline First (EDF) scheduler\n");
+            EarliestDeadlineFirst();
+            break;
         default:
             printf("Invalid choice. Exiting.\n");
+            stop_online_services();
             return 1;
     }
 
+    stop_online_services();
+
     printf("Scheduler finished. Results have been written to the appropriate CSV file.\n");
+    print_prediction_error(stderr);
     return 0;
 }
@@ -0,0 +1,102 @@
+#include "header_files/scheduler.h"
+
+// Runs any policy in either mode:
+//
+//   ./scheduler <policy> offline [parameters] < jobs
+//   ./scheduler <policy> <workload file> [parameters]
+//   ./scheduler <policy> online [parameters]
+//
+// Offline, every line of stdin is a job, all arriving at time 0, and the
+// run starts at end of file. A workload file (see workload.h) is replayed
+// offline instead, each job arriving at its own time; "-" reads it from
+// stdin. Online, jobs are read from stdin (and the
+// socket) until quit, as in online_schedulers.c. Lines may start with job
+// options such as [nice=5] or [deadline=2000]. The parameters are the
+// quantum for RR, Stride and Lottery, and quantum0 quantum1 quantum2
+// boostTime for MLFQ, all in ms.
+
+// Reads one job per line from stdin
+Process* read_offline_jobs(int* n) {
+    int capacity = 64;
+    Process* jobs = (Process*)calloc(capacity, sizeof(Process));
+    *n = 0;
+    char line[MAX_COMMAND_LENGTH];
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        line[strcspn(line, "\n")] = 0;
+        if (line[0] == '\0') {
+            continue;
+        }
+        if (*n == capacity) {
+            capacity *= 2;
+            jobs = (Process*)realloc(jobs, sizeof(Process) * capacity);
+            memset(jobs + *n, 0, sizeof(Process) * (capacity - *n));
+        }
+        jobs[*n].command = strdup(line);
+        jobs[*n].process_id = *n + 1;
+        (*n)++;
+    }
+    return jobs;
+}
+
+int main(int argc, char* argv[]) {
+    int policy = (argc >= 3) ? find_scheduler_policy(argv[1]) : -1;
+    SchedulerMode mode = (argc >= 3 && strcmp(argv[2], "online") == 0) ? SCHEDULER_ONLINE : SCHEDULER_OFFLINE;
+    const char* workload_path = (argc >= 3 && mode == SCHEDULER_OFFLINE && strcmp(argv[2], "offline") != 0) ? argv[2] : NULL;
+    int parameters = (policy == POLICY_MLFQ) ? 4 : (policy == POLICY_RR || policy == POLICY_STRIDE || policy == POLICY_LOTTERY) ? 1 : 0;
+    if (policy == -1 || (argc != 3 && argc != 3 + parameters)) {
+        fprintf(stderr, "Usage: %s <FCFS|RR|MLFQ|SJF|SRTF|CFS|Stride|Lottery|EDF> <offline|online|workload file> [quantum | quantum0 quantum1 quantum2 boostTime]\n", argv[0]);
+        return 1;
+    }
+
+    SchedulerParams params = {.quantum = 1000, .quantum0 = 1000, .quantum1 = 2000, .quantum2 = 3000, .boost_time = 5000};
+    if (argc == 4) {
+        params.quantum = atoi(argv[3]);
+    } else if (argc == 7) {
+        params.quantum0 = atoi(argv[3]);
+        params.quantum1 = atoi(argv[4]);
+        params.quantum2 = atoi(argv[5]);
+        params.boost_time = atoi(argv[6]);
+    }
+
+    HistoryFile history;
+    SubmitServer server;
+    if (start_online_services(&history, mode == SCHEDULER_ONLINE ? &server : NULL) < 0) {
+        stop_online_services();
+        return 1;
+    }
+
+    int n = 0;
+    Process* jobs = NULL;
+    WorkloadFile workload;
+    if (workload_path != NULL) {
+        if (open_workload(&workload, workload_path) < 0) {
+            stop_online_services();
+            return 1;
+        }
+    } else if (mode == SCHEDULER_OFFLINE) {
+        jobs = read_offline_jobs(&n);
+    } else {
+        // Unbuffered, so select() on stdin never misses lines already read into stdio
+        setvbuf(stdin, NULL, _IONBF, 0);
+    }
+
+    int result;
+    if (workload_path != NULL) {
+        result = run_scheduler_workload(policy, &params, &workload);
+        print_workload_stats(&workload, stderr);
+        close_workload(&workload);
+    } else {
+        result = run_scheduler(policy, mode, &params, jobs, n);
+    }
+    stop_online_services();
+    if (result == 0) {
+        fprintf(stderr, "Results written to result_%s_%s.csv\n", scheduler_mode_names[mode], scheduler_policy_names[policy]);
+        print_prediction_error(stderr);
+    }
+
+    for (int i = 0; i < n; i++) {
+        free(jobs[i].command);
+    }
+    free(jobs);
+    return result == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include "header_files/simulator.h"
+
+// Reads jobs from a file with one "<arrival ms> <burst ms> <command>" per line
+SimJob* load_jobs(const char* path, int* n) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        perror("Error opening job file");
+        return NULL;
+    }
+    int capacity = 1024;
+    SimJob* jobs = (SimJob*)malloc(sizeof(SimJob) * capacity);
+    *n = 0;
+
+    char line[MAX_COMMAND_LENGTH + 64];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        unsigned long arrival, burst;
+        int offset = 0;
+        if (sscanf(line, "%lu %lu %n", &arrival, &burst, &offset) != 2 || line[offset] == '\0') {
+            continue;  // Skip blank or malformed lines
+        }
+        line[strcspn(line, "\n")] = 0;
+        if (*n == capacity) {
+            capacity *= 2;
+            jobs = (SimJob*)realloc(jobs, sizeof(SimJob) * capacity);
+        }
+        jobs[*n].command = strdup(line + offset);
+        jobs[*n].arrival_time = arrival * NS_PER_MS;
+        jobs[*n].burst_time = burst * NS_PER_MS;
+        (*n)++;
+    }
+    fclose(file);
+    return jobs;
+}
+
+// Generates n jobs drawn from a handful of commands with fixed demands
+SimJob* generate_jobs(int n) {
+    static char* commands[] = {"short", "medium", "long", "batch"};
+    uint64_t bursts[] = {5, 50, 500, 5000};
+    SimJob* jobs = (SimJob*)malloc(sizeof(SimJob) * (n > 0 ? n : 1));
+    uint64_t arrival = 0;
+    srand(1);
+    for (int i = 0; i < n; i++) {
+        int kind = rand() % 4;
+        arrival += rand() % 200;
+        jobs[i].command = strdup(commands[kind]);
+        jobs[i].arrival_time = arrival * NS_PER_MS;
+        jobs[i].burst_time = (bursts[kind] / 2 + rand() % bursts[kind]) * NS_PER_MS;
+    }
+    return jobs;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3 && argc != 7) {
+        fprintf(stderr, "Usage: %s <FCFS|RR|MLFQ|SJF|SRTF|CFS|Stride|Lottery|EDF> <job file|random:N> [quantum0 quantum1 quantum2 boostTime]\n", argv[0]);
+        return 1;
+    }
+
+    int policy = find_scheduler_policy(argv[1]);
+    if (policy == -1) {
+        fprintf(stderr, "Unknown policy %s\n", argv[1]);
+        return 1;
+    }
+    if (burst_predictor_from_env() < 0) {
+        return 1;
+    }
+
+    int quantum0 = 1000, quantum1 = 2000, quantum2 = 3000, boostTime = 5000;
+    if (argc == 7) {
+        quantum0 = atoi(argv[3]);
+        quantum1 = atoi(argv[4]);
+        quantum2 = atoi(argv[5]);
+        boostTime = atoi(argv[6]);
+    }
+
+    int n = 0;
+    SimJob* jobs;
+    if (strncmp(argv[2], "random:", 7) == 0) {
+        n = atoi(argv[2] + 7);
+        jobs = generate_jobs(n);
+    } else {
+        jobs = load_jobs(argv[2], &n);
+    }
+    if (jobs == NULL) {
+        return 1;
+    }
+
+    uint64_t start = clock_ns();
+    SimStats stats = Simulate(jobs, n, policy, quantum0, quantum1, quantum2, boostTime);
+    uint64_t elapsed = (clock_ns() - start) / NS_PER_MS;
+
+    fprintf(stderr, "Simulated %d jobs, %lu events, %lu ms of virtual time in %lu ms (%.0f events/s)\n",
+            n, stats.events, stats.end_time / NS_PER_MS, elapsed, elapsed ? stats.events * 1000.0 / elapsed : 0.0);
+    print_prediction_error(stderr);
+    fprintf(stderr, "Results written to result_sim_%s.csv\n", scheduler_policy_names[policy]);
+
+    for (int i = 0; i < n; i++) {
+        free(jobs[i].command);
+    }
+    free(jobs);
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Submits jobs to an online scheduler started with SCHEDULER_SOCKET=<path>.
+// Commands are taken from the arguments, or one per line from stdin when
+// there are none, and sent over a single connection. Send "quit" to stop
+// the scheduler.
+int write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += written;
+        len -= written;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <socket> [command...]\n", argv[0]);
+        return 1;
+    }
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(argv[1]) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", argv[1]);
+        return 1;
+    }
+    strcpy(addr.sun_path, argv[1]);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("Error connecting to scheduler");
+        return 1;
+    }
+
+    int ret = 0;
+    if (argc > 2) {
+        // Send the whole batch in one write
+        size_t len = 0;
+        for (int i = 2; i < argc; i++) {
+            len += strlen(argv[i]) + 1;
+        }
+        char* batch = (char*)malloc(len);
+        char* end = batch;
+        for (int i = 2; i < argc; i++) {
+            size_t n = strlen(argv[i]);
+            memcpy(end, argv[i], n);
+            end[n] = '\n';
+            end += n + 1;
+        }
+        ret = write_all(fd, batch, len);
+        free(batch);
+    } else {
+        char buffer[8192];
+        size_t got;
+        while (ret == 0 && (got = fread(buffer, 1, sizeof(buffer), stdin)) > 0) {
+            ret = write_all(fd, buffer, got);
+        }
+    }
+    if (ret < 0) {
+        perror("Error submitting jobs");
+    }
+    close(fd);
+    return ret < 0 ? 1 : 0;
+}
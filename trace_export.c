@@ -0,0 +1,23 @@
+#include "header_files/trace.h"
+
+// Converts a binary scheduler trace (written when SCHEDULER_TRACE is set)
+// to Chrome trace-event JSON for chrome://tracing or ui.perfetto.dev
+int main(int argc, char* argv[]) {
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: %s <trace file> [output.json]\n", argv[0]);
+        return 1;
+    }
+    FILE* out = stdout;
+    if (argc == 3) {
+        out = fopen(argv[2], "w");
+        if (out == NULL) {
+            perror("Error opening output file");
+            return 1;
+        }
+    }
+    int ret = export_chrome_trace(argv[1], out);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return ret < 0 ? 1 : 0;
+}